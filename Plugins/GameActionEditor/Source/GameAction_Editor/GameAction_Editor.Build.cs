@@ -56,6 +56,7 @@ public class GameAction_Editor : ModuleRules
 				"PropertyEditor",
 				"SceneOutliner",
 				"KismetWidgets",
+				"AssetRegistry",
 
 				"GameAction_Runtime",
 				// ... add private dependencies that you statically link with here ...	
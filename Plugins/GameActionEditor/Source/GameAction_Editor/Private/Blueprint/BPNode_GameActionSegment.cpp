@@ -359,7 +359,18 @@ TSharedPtr<SGraphNode> UBPNode_GameActionSegmentBase::CreateVisualWidget()
 					{
 						const FLinearColor InactiveStateColor(0.08f, 0.08f, 0.08f);
 						const FLinearColor ActiveStateColorBright(1.f, 0.6f, 0.35f);
-						return CastChecked<UBPNode_GameActionSegmentBase>(GetNodeObj())->DebugState == EDebugState::Actived ? ActiveStateColorBright : InactiveStateColor;
+						const FLinearColor ActiveStateColorDim(0.4f, 0.3f, 0.15f);
+						const UBPNode_GameActionSegmentBase* Node = CastChecked<UBPNode_GameActionSegmentBase>(GetNodeObj());
+						if (Node->DebugState == EDebugState::Actived)
+						{
+							return ActiveStateColorBright;
+						}
+						// 轨迹中越早激活的片段颜色越暗
+						if (Node->DebugTrailIndex != INDEX_NONE)
+						{
+							return FMath::Lerp(ActiveStateColorDim, InactiveStateColor, FMath::Clamp((float)Node->DebugTrailIndex / UBPNode_GameActionSegmentBase::MaxDebugTrailNum, 0.f, 1.f));
+						}
+						return InactiveStateColor;
 					})
 					[
 						SNew(SOverlay)
@@ -423,6 +434,21 @@ TSharedPtr<SGraphNode> UBPNode_GameActionSegmentBase::CreateVisualWidget()
 										[
 											NodeTitle.ToSharedRef()
 										]
+										// 调试轨迹：序号、激活时间与停留时长
+										+SVerticalBox::Slot()
+										.AutoHeight()
+										[
+											SNew(STextBlock)
+											.Visibility_Lambda([=]
+											{
+												return CastChecked<UBPNode_GameActionSegmentBase>(GetNodeObj())->DebugTrailIndex != INDEX_NONE ? EVisibility::Visible : EVisibility::Collapsed;
+											})
+											.Text_Lambda([=]
+											{
+												const UBPNode_GameActionSegmentBase* Node = CastChecked<UBPNode_GameActionSegmentBase>(GetNodeObj());
+												return FText::FromString(FString::Printf(TEXT("#%d  %.2fs  停留%.2fs"), Node->DebugTrailIndex, Node->DebugActivedTime, Node->DebugTimeSpent));
+											})
+										]
 									]
 								]
 								// PIN AREA
@@ -696,6 +722,7 @@ void UBPNode_GameActionSegmentBase::ExpandNode(FKismetCompilerContext& CompilerC
 			TickData.Condition = TransitionConditionName;
 			TickData.SegmentName = NextSegmentNode->GetRefVarName();
 			TickData.Order = TransitionNode->NodePosY;
+			TickData.Dependency = TransitionNode->AnalyzeConditionDependency();
 		}
 		break;
 		case EGameActionTransitionType::Event:
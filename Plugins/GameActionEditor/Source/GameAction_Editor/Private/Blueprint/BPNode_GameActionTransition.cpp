@@ -16,6 +16,16 @@
 #include <K2Node_IfThenElse.h>
 #include <K2Node_Knot.h>
 #include <K2Node_DynamicCast.h>
+#include <K2Node_VariableGet.h>
+#include <K2Node_Self.h>
+#include <K2Node_Select.h>
+#include <K2Node_MakeStruct.h>
+#include <K2Node_BreakStruct.h>
+#include <K2Node_EnumEquality.h>
+#include <Kismet/KismetMathLibrary.h>
+#include <Kismet/KismetStringLibrary.h>
+#include <Kismet/KismetTextLibrary.h>
+#include <Kismet/KismetArrayLibrary.h>
 #include <Widgets/Layout/SConstraintCanvas.h>
 #include <IDocumentation.h>
 #include <SKismetLinearExpression.h>
@@ -25,7 +35,10 @@
 
 #include "Blueprint/BPNode_GameActionEntry.h"
 #include "Blueprint/BPNode_GameActionSegment.h"
+#include "Blueprint/BPNode_SequenceTimeTestingNode.h"
+#include "GameAction/GameActionComponent.h"
 #include "GameAction/GameActionSegment.h"
+#include "Sequence/GameActionTimeTestingTrack.h"
 
 #define LOCTEXT_NAMESPACE "BPNode_GameActionTransition"
 
@@ -506,6 +519,132 @@ void UBPNode_GameActionTransitionBase::UpdateBoundGraphName()
 	BoundGraph->EntryNode->CustomGeneratedFunctionName = GetTransitionName();
 }
 
+namespace GameActionTransitionDependencyUtils
+{
+	// 结果只由输入决定的纯函数
+	bool IsDeterministicPureFunction(const UFunction* Function)
+	{
+		if (Function->HasAnyFunctionFlags(FUNC_BlueprintPure) == false)
+		{
+			return false;
+		}
+		const UClass* OwnerClass = Function->GetOwnerClass();
+		if (OwnerClass != UKismetMathLibrary::StaticClass() && OwnerClass != UKismetStringLibrary::StaticClass() &&
+			OwnerClass != UKismetTextLibrary::StaticClass() && OwnerClass != UKismetArrayLibrary::StaticClass())
+		{
+			return false;
+		}
+		const FString FunctionName = Function->GetName();
+		return FunctionName.StartsWith(TEXT("Random")) == false && FunctionName != TEXT("Now") && FunctionName != TEXT("UtcNow") && FunctionName != TEXT("Today");
+	}
+
+	bool AnalyzeNode(const UEdGraphNode* Node, FGameActionTransitionDependency& Dependency)
+	{
+		if (Node->IsA<UK2Node_FunctionEntry>() || Node->IsA<UK2Node_Knot>() || Node->IsA<UK2Node_Self>() || Node->IsA<UBPNode_GetOwningSegment>() ||
+			Node->IsA<UK2Node_Select>() || Node->IsA<UK2Node_MakeStruct>() || Node->IsA<UK2Node_BreakStruct>() || Node->IsA<UK2Node_EnumEquality>())
+		{
+			return true;
+		}
+		if (const UK2Node_DynamicCast* CastNode = Cast<UK2Node_DynamicCast>(Node))
+		{
+			return CastNode->IsNodePure();
+		}
+		if (const UBPNode_SequenceTimeTestingNode* TimeTestingNode = Cast<UBPNode_SequenceTimeTestingNode>(Node))
+		{
+			if (TimeTestingNode->TestingSection == nullptr)
+			{
+				return false;
+			}
+			const TRange<FFrameNumber> Range = TimeTestingNode->TestingSection->GetRange();
+			FGameActionTransitionTimeWindow& TimeWindow = Dependency.TimeWindows.AddDefaulted_GetRef();
+			TimeWindow.Lower = Range.GetLowerBoundValue();
+			TimeWindow.Upper = Range.GetUpperBoundValue();
+			return true;
+		}
+		if (const UK2Node_VariableGet* VariableGetNode = Cast<UK2Node_VariableGet>(Node))
+		{
+			if (VariableGetNode->VariableReference.IsLocalScope())
+			{
+				return true;
+			}
+			// 只追踪行为实例自身的变量
+			const UEdGraphPin* SelfPin = VariableGetNode->FindPin(UEdGraphSchema_K2::PN_Self);
+			if (VariableGetNode->VariableReference.IsSelfContext() && (SelfPin == nullptr || SelfPin->LinkedTo.Num() == 0))
+			{
+				Dependency.InstanceVariables.AddUnique(VariableGetNode->GetVarName());
+				return true;
+			}
+			return false;
+		}
+		if (const UK2Node_CallFunction* CallFunctionNode = Cast<UK2Node_CallFunction>(Node))
+		{
+			const UFunction* Function = CallFunctionNode->GetTargetFunction();
+			if (Function == nullptr)
+			{
+				return false;
+			}
+			if (Function->GetOwnerClass() == UGameActionComponent::StaticClass() && Function->GetFName() == GET_FUNCTION_NAME_CHECKED(UGameActionComponent, HasGameActionTag))
+			{
+				Dependency.bOwnerTags = true;
+				return true;
+			}
+			return IsDeterministicPureFunction(Function);
+		}
+		return false;
+	}
+}
+
+FGameActionTransitionDependency UBPNode_GameActionTransitionBase::AnalyzeConditionDependency() const
+{
+	using namespace GameActionTransitionResultUtils;
+
+	FGameActionTransitionDependency Dependency;
+	if (BoundGraph == nullptr || BoundGraph->ResultNode == nullptr || BoundGraph->EntryNode == nullptr)
+	{
+		return Dependency;
+	}
+	// 入口与结果节点之间插入了执行节点时无法分析
+	const UEdGraphPin* ExecutePin = BoundGraph->ResultNode->FindPinChecked(UEdGraphSchema_K2::PN_Execute);
+	if (ExecutePin->LinkedTo.Num() != 1 || ExecutePin->LinkedTo[0]->GetOwningNode() != BoundGraph->EntryNode)
+	{
+		return Dependency;
+	}
+
+	// 本地只使用自主端的结果，从该引脚反向遍历数据连线
+	TArray<const UEdGraphNode*, TInlineAllocator<16>> PendingNodes;
+	TSet<const UEdGraphNode*> VisitedNodes;
+	for (const UEdGraphPin* LinkedPin : BoundGraph->ResultNode->FindPinChecked(AutonomousPinName, EGPD_Input)->LinkedTo)
+	{
+		PendingNodes.Add(LinkedPin->GetOwningNode());
+	}
+	while (PendingNodes.Num() > 0)
+	{
+		const UEdGraphNode* Node = PendingNodes.Pop(false);
+		bool bIsAlreadyVisited = false;
+		VisitedNodes.Add(Node, &bIsAlreadyVisited);
+		if (bIsAlreadyVisited)
+		{
+			continue;
+		}
+		if (GameActionTransitionDependencyUtils::AnalyzeNode(Node, Dependency) == false)
+		{
+			return FGameActionTransitionDependency();
+		}
+		for (const UEdGraphPin* Pin : Node->Pins)
+		{
+			if (Pin->Direction == EGPD_Input && Pin->PinType.PinCategory != UEdGraphSchema_K2::PC_Exec)
+			{
+				for (const UEdGraphPin* LinkedPin : Pin->LinkedTo)
+				{
+					PendingNodes.Add(LinkedPin->GetOwningNode());
+				}
+			}
+		}
+	}
+	Dependency.bUnknown = false;
+	return Dependency;
+}
+
 const FLinearColor UBPNode_GameActionTransitionBase::HoverColor(0.724f, 0.256f, 0.0f, 1.0f);
 const FLinearColor UBPNode_GameActionTransitionBase::BaseColor(0.9f, 0.9f, 0.9f, 1.0f);
 
@@ -716,6 +716,7 @@ void FGameActionEditor::CreateDefaultCommands()
 					Switcher->RemoveSlot(Switcher->GetWidget(1).ToSharedRef());
 					SimulateScene.Reset();
 					SimulationViewport.Reset();
+					EditScene->bSuspendWorldTick = false;
 
 					GetInspector()->ShowDetailsForSingleObject(nullptr);
 				}
@@ -737,6 +738,8 @@ void FGameActionEditor::CreateDefaultCommands()
 					
 					TSharedPtr<SWidgetSwitcher> Switcher = ViewportWidgetSwitcher.Pin();
 					SimulateScene = MakeShareable(new FGameActionSimulateScene(CastChecked<UGameActionBlueprint>(GetBlueprintObj())));
+					// 模拟期间编辑场景不可见，暂停其世界更新
+					EditScene->bSuspendWorldTick = true;
 					Switcher->AddSlot(1)
 						[
 							SAssignNew(SimulationViewport, SGameActionSimulationViewport, SharedThis(this))
@@ -845,34 +848,104 @@ UWorld* FGameActionEditor::GetWorld() const
 
 void FGameActionEditor::FGameActionDebugger::Tick(float DeltaTime)
 {
-	if (UGameActionBlueprint* Blueprint = Cast<UGameActionBlueprint>(GameActionEditor.GetBlueprintObj()))
+	UGameActionBlueprint* Blueprint = Cast<UGameActionBlueprint>(GameActionEditor.GetBlueprintObj());
+	if (Blueprint == nullptr)
 	{
-		UGameActionInstanceBase* DebugInstance = Cast<UGameActionInstanceBase>(Blueprint->GetObjectBeingDebugged());
-		if (DebugInstance == nullptr && GameActionEditor.SimulateScene.IsValid())
+		return;
+	}
+
+	UGameActionInstanceBase* Instance = Cast<UGameActionInstanceBase>(Blueprint->GetObjectBeingDebugged());
+	if (Instance == nullptr && GameActionEditor.SimulateScene.IsValid())
+	{
+		Instance = GameActionEditor.SimulateScene->GetGameActionInstance();
+	}
+	const UWorld* World = Instance ? Instance->GetWorld() : nullptr;
+	const float WorldTime = World ? World->GetTimeSeconds() : 0.f;
+
+	bool bTrailChanged = false;
+	// 调试对象被销毁后也需要通知监听者，不再接收事件
+	if (Instance != DebugInstance.Get() || (Instance == nullptr && DebugInstance.IsExplicitlyNull() == false))
+	{
+		ResetTrail();
+		DebugInstance = Instance;
+		DebugEventListener.SetDebugInstance(Instance);
+		bTrailChanged = true;
+		// 切换调试对象时补上当前激活的片段
+		if (Instance && Instance->ActivedSegment)
 		{
-			DebugInstance = GameActionEditor.SimulateScene->GetGameActionInstance();
+			Trail.Add({ Instance->ActivedSegment->GetBPNodeTemplate(), WorldTime });
 		}
-		if (DebugInstance && DebugInstance->ActivedSegment)
+	}
+
+	FGameActionDebugEvent Event;
+	while (DebugEventListener.Dequeue(Event))
+	{
+		if (Instance == nullptr || Event.Instance.Get() != Instance)
 		{
-			UBPNode_GameActionSegmentBase* BPNode_GameActionSegment = DebugInstance->ActivedSegment->GetBPNodeTemplate();
-			if (BPNode_GameActionSegment != PreActicedNode.Get())
-			{
-				if (PreActicedNode.IsValid())
-				{
-					PreActicedNode->DebugState = UBPNode_GameActionSegmentBase::EDebugState::Deactived;
-				}
-				PreActicedNode = BPNode_GameActionSegment;
-				BPNode_GameActionSegment->DebugState = UBPNode_GameActionSegmentBase::EDebugState::Actived;
-			}
+			continue;
 		}
-		else
+		const UGameActionSegmentBase* Segment = Event.Segment.Get();
+		UBPNode_GameActionSegmentBase* Node = Segment ? Segment->GetBPNodeTemplate() : nullptr;
+		if (Node == nullptr)
 		{
-			if (PreActicedNode.IsValid())
+			continue;
+		}
+
+		if (Event.Type == FGameActionDebugEvent::EType::Actived)
+		{
+			Trail.Insert({ Node, Event.WorldTime }, 0);
+			if (Trail.Num() > MaxTrailNum)
 			{
-				PreActicedNode->DebugState = UBPNode_GameActionSegmentBase::EDebugState::Deactived;
-				PreActicedNode.Reset();
+				Trail.SetNum(MaxTrailNum);
 			}
 		}
+		else if (FTrailRecord* Record = Trail.FindByPredicate([&](const FTrailRecord& E) { return E.Node == Node && E.DeactivedTime < 0.f; }))
+		{
+			Record->DeactivedTime = Event.WorldTime;
+		}
+		bTrailChanged = true;
+	}
+
+	// 只有轨迹变化或仍有激活片段时才需要刷新节点的停留时间
+	if (bTrailChanged || (Trail.Num() > 0 && Trail[0].DeactivedTime < 0.f))
+	{
+		UpdateNodeDebugStates(WorldTime);
+	}
+}
+
+void FGameActionEditor::FGameActionDebugger::ResetTrail()
+{
+	Trail.Empty();
+	UpdateNodeDebugStates(0.f);
+}
+
+void FGameActionEditor::FGameActionDebugger::UpdateNodeDebugStates(float WorldTime)
+{
+	for (const TWeakObjectPtr<UBPNode_GameActionSegmentBase>& DisplayedNode : DisplayedNodes)
+	{
+		if (UBPNode_GameActionSegmentBase* Node = DisplayedNode.Get())
+		{
+			Node->DebugState = UBPNode_GameActionSegmentBase::EDebugState::Deactived;
+			Node->DebugTrailIndex = INDEX_NONE;
+		}
+	}
+	DisplayedNodes.Reset();
+
+	for (int32 Idx = 0; Idx < Trail.Num(); ++Idx)
+	{
+		const FTrailRecord& Record = Trail[Idx];
+		UBPNode_GameActionSegmentBase* Node = Record.Node.Get();
+		// 同一节点多次出现时只显示最近一次
+		if (Node == nullptr || Node->DebugTrailIndex != INDEX_NONE)
+		{
+			continue;
+		}
+		const bool bIsActived = Record.DeactivedTime < 0.f;
+		Node->DebugState = bIsActived ? UBPNode_GameActionSegmentBase::EDebugState::Actived : UBPNode_GameActionSegmentBase::EDebugState::Deactived;
+		Node->DebugTrailIndex = Idx;
+		Node->DebugActivedTime = Record.ActivedTime;
+		Node->DebugTimeSpent = (bIsActived ? WorldTime : Record.DeactivedTime) - Record.ActivedTime;
+		DisplayedNodes.Add(Node);
 	}
 }
 
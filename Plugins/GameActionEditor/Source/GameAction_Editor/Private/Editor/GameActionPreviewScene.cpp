@@ -9,13 +9,19 @@
 #include <Animation/AnimInstance.h>
 #include <Kismet/GameplayStatics.h>
 #include <GameFramework/GameStateBase.h>
+#include <HAL/IConsoleManager.h>
 
 #include "Blueprint/GameActionBlueprint.h"
 #include "GameAction/GameActionComponent.h"
 #include "GameAction/GameActionInstance.h"
 
+static TAutoConsoleVariable<float> CVarGameActionPreviewIdleTickRate(
+	TEXT("GameAction.PreviewIdleTickRate"),
+	10.f,
+	TEXT("GameAction编辑器预览场景空闲时（未播放、未拖动时间轴、未模拟）每秒更新世界的次数，小于等于0时空闲不更新"));
+
 FGameActionPreviewScene::FGameActionPreviewScene(ConstructionValues CVS, UGameActionBlueprint* InGameActionBlueprint)
-	: Super(CVS), GameActionBlueprint(InGameActionBlueprint)
+	: Super(CVS), bSuspendWorldTick(false), GameActionBlueprint(InGameActionBlueprint), bWorldTickRequested(false)
 {
 	UWorld* World = GetWorld();
 	World->bAllowAudioPlayback = true;
@@ -43,7 +49,32 @@ void FGameActionPreviewScene::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	GetWorld()->Tick(LEVELTICK_All, DeltaTime);
+	if (bSuspendWorldTick)
+	{
+		PendingIdleDeltaTime = 0.f;
+		return;
+	}
+
+	if (IsRealtimeWorldTick())
+	{
+		PendingIdleDeltaTime = 0.f;
+		bWorldTickRequested = false;
+		GetWorld()->Tick(LEVELTICK_All, DeltaTime);
+		return;
+	}
+
+	// 空闲时累积时间降频更新，保证动画预览的播放速度不变
+	PendingIdleDeltaTime += DeltaTime;
+	const float IdleTickRate = CVarGameActionPreviewIdleTickRate.GetValueOnGameThread();
+	const bool bIdleTickDue = IdleTickRate > 0.f && PendingIdleDeltaTime >= 1.f / IdleTickRate;
+	if (bIdleTickDue || bWorldTickRequested)
+	{
+		// 避免长时间未更新后一次推进过大的时间
+		const float WorldDeltaTime = IdleTickRate > 0.f ? FMath::Min(PendingIdleDeltaTime, 1.f / IdleTickRate) : DeltaTime;
+		PendingIdleDeltaTime = 0.f;
+		bWorldTickRequested = false;
+		GetWorld()->Tick(LEVELTICK_All, WorldDeltaTime);
+	}
 }
 
 void FGameActionPreviewScene::SetPreviewGameActionScene(UGameActionScene* GameActionScene)
@@ -0,0 +1,270 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameAction/GameActionCommandlets.h"
+#include <AssetRegistryModule.h>
+#include <MovieScene.h>
+#include <Kismet2/KismetEditorUtilities.h>
+#include <Compilation/MovieSceneCompiledDataManager.h>
+
+#include "Blueprint/GameActionBlueprint.h"
+#include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionSegment.h"
+#include "Sequence/GameActionDynamicSpawnTrack.h"
+#include "Sequence/GameActionSequence.h"
+#include "Sequence/GameActionSequenceCustomSpawner.h"
+#include "Utils/GameActionMemReport.h"
+#include "Utils/GameAction_Log.h"
+
+namespace GameActionCommandletUtils
+{
+	TArray<UGameActionBlueprint*> LoadAllGameActionBlueprints()
+	{
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		AssetRegistry.SearchAllAssets(true);
+
+		TArray<FAssetData> AssetDatas;
+		AssetRegistry.GetAssetsByClass(UGameActionBlueprint::StaticClass()->GetFName(), AssetDatas, true);
+
+		TArray<UGameActionBlueprint*> Blueprints;
+		for (const FAssetData& AssetData : AssetDatas)
+		{
+			if (UGameActionBlueprint* Blueprint = Cast<UGameActionBlueprint>(AssetData.GetAsset()))
+			{
+				Blueprints.Add(Blueprint);
+			}
+			else
+			{
+				GameAction_Log(Warning, "加载%s失败", *AssetData.ObjectPath.ToString());
+			}
+		}
+		return Blueprints;
+	}
+
+	struct FGameActionValidator
+	{
+		int32 ErrorCount = 0;
+
+		void Error(const UObject* Context, const FString& Message)
+		{
+			ErrorCount += 1;
+			GameAction_Log(Error, "[%s] %s", *GetPathNameSafe(Context), *Message);
+		}
+
+		void ValidateTransition(const UObject* Context, const FGameActionTransitionBase& Transition)
+		{
+			if (Transition.TransitionToSegment == nullptr)
+			{
+				Error(Context, TEXT("跳转目标为空"));
+			}
+			if (Transition.Condition.IsBound())
+			{
+				const UObject* ConditionObject = Transition.Condition.GetUObject();
+				if (ConditionObject == nullptr || ConditionObject->FindFunction(Transition.Condition.GetFunctionName()) == nullptr)
+				{
+					Error(Context, FString::Printf(TEXT("跳转条件函数[%s]不存在"), *Transition.Condition.GetFunctionName().ToString()));
+				}
+			}
+		}
+
+		void ValidateSequence(UClass* InstanceClass, const UGameActionSegment* Segment, UGameActionSequence* Sequence)
+		{
+			UMovieScene* MovieScene = Sequence->GetMovieScene();
+			if (MovieScene == nullptr)
+			{
+				Error(Segment, TEXT("序列中的MovieScene为空"));
+				return;
+			}
+
+			for (const TPair<FGuid, FName>& Pair : Sequence->PossessableActors)
+			{
+				const TFieldPath<FObjectProperty>* CompiledProperty = Sequence->CompiledPossessableProperties.Find(Pair.Key);
+				if (CompiledProperty == nullptr || CompiledProperty->Get() == nullptr)
+				{
+					Error(Sequence, FString::Printf(TEXT("Possessable[%s]未预先解析，请重新编译"), *Pair.Value.ToString()));
+				}
+			}
+			for (const TPair<FGuid, FGameActionSequenceSubobjectBinding>& Pair : Sequence->BindingSubobjects)
+			{
+				const FGameActionSequenceSubobjectBinding& SubobjectBinding = Pair.Value;
+				if (SubobjectBinding.SubobjectNames.Num() == 0)
+				{
+					Error(Sequence, FString::Printf(TEXT("子对象绑定[%s]未预先解析，请重新编译"), *SubobjectBinding.PathToSubobject));
+				}
+				if (SubobjectBinding.OwnerPropertyName != UGameActionInstanceBase::GameActionOwnerName && SubobjectBinding.OwnerProperty.Get() == nullptr)
+				{
+					Error(Sequence, FString::Printf(TEXT("子对象绑定[%s]的所属属性[%s]不存在"), *SubobjectBinding.PathToSubobject, *SubobjectBinding.OwnerPropertyName.ToString()));
+				}
+			}
+
+			for (int32 Idx = 0; Idx < MovieScene->GetSpawnableCount(); ++Idx)
+			{
+				const FMovieSceneSpawnable& Spawnable = MovieScene->GetSpawnable(Idx);
+				const UObject* Template = Spawnable.GetObjectTemplate();
+				if (Template == nullptr)
+				{
+					Error(Sequence, FString::Printf(TEXT("Spawnable[%s]的模板为空"), *Spawnable.GetName()));
+					continue;
+				}
+				if (Template->GetTypedOuter<UBlueprint>())
+				{
+					Error(Template, TEXT("Spawnable模板的Outer为蓝图，打包后会丢失"));
+				}
+
+				const UGameActionDynamicSpawnTrack* SpawnTrack = MovieScene->FindTrack<UGameActionDynamicSpawnTrack>(Spawnable.GetGuid());
+				if (SpawnTrack == nullptr || SpawnTrack->SpawnSection.Num() != 1)
+				{
+					Error(Sequence, FString::Printf(TEXT("Spawnable[%s]缺少生成轨道"), *Spawnable.GetName()));
+					continue;
+				}
+				const UGameActionSequenceSpawnerSettingsBase* SpawnerSettings = SpawnTrack->SpawnSection[0]->GetSpawnerSettings();
+				if (SpawnerSettings == nullptr)
+				{
+					Error(Sequence, FString::Printf(TEXT("Spawnable[%s]缺少生成器设置"), *Spawnable.GetName()));
+					continue;
+				}
+				if (SpawnerSettings->bAsReference)
+				{
+					const FObjectProperty* ReferenceProperty = SpawnerSettings->ReferenceProperty.Get();
+					if (ReferenceProperty == nullptr || InstanceClass->IsChildOf(ReferenceProperty->GetOwnerClass()) == false)
+					{
+						Error(SpawnerSettings, FString::Printf(TEXT("Spawnable[%s]为引用但引用属性未预先解析，请重新编译"), *Spawnable.GetName()));
+					}
+				}
+			}
+
+			// 打包时引擎将编译数据随序列保存，以下情况运行时仍会重新编译
+			if (EnumHasAnyFlags(Sequence->GetFlags(), EMovieSceneSequenceFlags::Volatile))
+			{
+				Error(Sequence, TEXT("序列标记为Volatile，运行时每次求值都会检查并重新编译"));
+			}
+			// Compile后的数据总是最新的，需在编译前检查已有的编译数据
+			UMovieSceneCompiledDataManager* CompiledDataManager = UMovieSceneCompiledDataManager::GetPrecompiledData();
+			const FMovieSceneCompiledDataID ExistingDataID = CompiledDataManager->FindDataID(Sequence);
+			if (ExistingDataID.IsValid() == false)
+			{
+				Error(Sequence, TEXT("序列没有预编译数据，运行时会重新编译"));
+			}
+			else if (CompiledDataManager->IsDirty(ExistingDataID))
+			{
+				Error(Sequence, TEXT("预编译数据的签名与序列不一致，运行时会重新编译"));
+			}
+			if (CompiledDataManager->Compile(Sequence).IsValid() == false)
+			{
+				Error(Sequence, TEXT("求值模板编译失败"));
+			}
+		}
+
+		void ValidateBlueprint(UGameActionBlueprint* Blueprint)
+		{
+			if (Blueprint->Status != EBlueprintStatus::BS_UpToDate && Blueprint->Status != EBlueprintStatus::BS_UpToDateWithWarnings)
+			{
+				FKismetEditorUtilities::CompileBlueprint(Blueprint, EBlueprintCompileOptions::SkipGarbageCollection);
+			}
+			if (Blueprint->Status == EBlueprintStatus::BS_Error || Blueprint->GeneratedClass == nullptr)
+			{
+				Error(Blueprint, TEXT("蓝图编译失败"));
+				return;
+			}
+
+			UClass* InstanceClass = Blueprint->GeneratedClass;
+			UGameActionInstanceBase* InstanceCDO = InstanceClass->GetDefaultObject<UGameActionInstanceBase>();
+			for (TFieldIterator<FStructProperty> It(InstanceClass); It; ++It)
+			{
+				if (It->Struct->IsChildOf(StaticStruct<FGameActionEntry>()))
+				{
+					for (const FGameActionEntryTransition& EntryTransition : It->ContainerPtrToValuePtr<FGameActionEntry>(InstanceCDO)->Transitions)
+					{
+						ValidateTransition(Blueprint, EntryTransition);
+					}
+				}
+			}
+
+			for (TFieldIterator<FObjectProperty> It(InstanceClass); It; ++It)
+			{
+				if (It->GetBoolMetaData(UGameActionBlueprint::MD_GameActionTemplateReference) == false)
+				{
+					continue;
+				}
+				const UGameActionSegmentBase* SegmentTemplate = *It->ContainerPtrToValuePtr<UGameActionSegmentBase*>(InstanceCDO);
+				if (SegmentTemplate == nullptr)
+				{
+					Error(Blueprint, FString::Printf(TEXT("行为片段[%s]模板为空"), *It->GetName()));
+					continue;
+				}
+				for (const FGameActionTickTransition& TickTransition : SegmentTemplate->TickTransitions)
+				{
+					ValidateTransition(SegmentTemplate, TickTransition);
+				}
+				for (const FGameActionEventTransition& EventTransition : SegmentTemplate->EventTransitions)
+				{
+					ValidateTransition(SegmentTemplate, EventTransition);
+				}
+
+				if (const UGameActionSegment* Segment = Cast<UGameActionSegment>(SegmentTemplate))
+				{
+					UGameActionSequence* Sequence = Segment->bLazyLoadSequence ? Segment->LazyGameActionSequence.LoadSynchronous() : Segment->GameActionSequence;
+					if (Sequence == nullptr)
+					{
+						Error(Segment, TEXT("行为片段的序列为空"));
+						continue;
+					}
+					ValidateSequence(InstanceClass, Segment, Sequence);
+				}
+			}
+		}
+	};
+}
+
+UGameActionMemReportCommandlet::UGameActionMemReportCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UGameActionMemReportCommandlet::Main(const FString& Params)
+{
+	const TArray<UGameActionBlueprint*> Blueprints = GameActionCommandletUtils::LoadAllGameActionBlueprints();
+	GameAction_Log(Display, "共加载%d个GameAction蓝图", Blueprints.Num());
+
+	FGameActionMemReport MemReport;
+	MemReport.Gather(nullptr, true);
+	MemReport.Print(*GLog);
+
+	FString CsvPath;
+	if (FParse::Value(*Params, TEXT("csv="), CsvPath) == false)
+	{
+		CsvPath = FGameActionMemReport::MakeDefaultCsvPath();
+	}
+	if (MemReport.SaveCsv(CsvPath) == false)
+	{
+		GameAction_Log(Error, "GameAction MemReport保存至%s失败", *CsvPath);
+		return 1;
+	}
+	GameAction_Log(Display, "GameAction MemReport已保存至%s", *CsvPath);
+	return 0;
+}
+
+UGameActionValidateCommandlet::UGameActionValidateCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UGameActionValidateCommandlet::Main(const FString& Params)
+{
+	const TArray<UGameActionBlueprint*> Blueprints = GameActionCommandletUtils::LoadAllGameActionBlueprints();
+
+	GameActionCommandletUtils::FGameActionValidator Validator;
+	for (UGameActionBlueprint* Blueprint : Blueprints)
+	{
+		Validator.ValidateBlueprint(Blueprint);
+	}
+
+	GameAction_Log(Display, "校验%d个GameAction蓝图，错误%d个", Blueprints.Num(), Validator.ErrorCount);
+	return Validator.ErrorCount > 0 ? 1 : 0;
+}
@@ -11,6 +11,10 @@
 #include <GameFramework/Actor.h>
 #include <Engine/Engine.h>
 #include <Engine/BlueprintGeneratedClass.h>
+#include <AssetRegistryModule.h>
+#include <Misc/PackageName.h>
+#include <Serialization/MemoryWriter.h>
+#include <Serialization/ObjectAndNameAsStringProxyArchive.h>
 
 #include "GameAction_Editor.h"
 #include "Blueprint/GameActionBlueprint.h"
@@ -24,6 +28,57 @@
 #include "Sequence/GameActionSequence.h"
 #include "Sequence/GameActionSequenceCustomSpawner.h"
 
+namespace GameActionCompilerUtils
+{
+	// 根对象内部的引用按相对路径写入，内容相同的对象移至其它资源包后哈希不变
+	class FContentHashArchive : public FObjectAndNameAsStringProxyArchive
+	{
+	public:
+		FContentHashArchive(FArchive& InInnerArchive, UObject* InRoot)
+			: FObjectAndNameAsStringProxyArchive(InInnerArchive, false)
+			, Root(InRoot)
+		{}
+
+		FArchive& operator<<(UObject*& Obj) override
+		{
+			if (Obj && (Obj == Root || Obj->IsIn(Root)))
+			{
+				FString RelativePath = Obj->GetPathName(Root);
+				InnerArchive << RelativePath;
+				return *this;
+			}
+			return FObjectAndNameAsStringProxyArchive::operator<<(Obj);
+		}
+	private:
+		UObject* Root;
+	};
+
+	// 计算对象及其所有子对象序列化后的哈希，用于判断片段内容是否变化
+	// 对象引用按路径名序列化，指针值每次启动编辑器都不同，且地址复用时会误判为相同
+	uint32 ComputeContentHash(UObject* Root)
+	{
+		TArray<UObject*> Objects;
+		GetObjectsWithOuter(Root, Objects, true);
+		Objects.RemoveAll([](UObject* Object) { return Object->IsPendingKill(); });
+		Objects.Sort([Root](const UObject& LHS, const UObject& RHS) { return LHS.GetPathName(Root) < RHS.GetPathName(Root); });
+		Objects.Insert(Root, 0);
+
+		uint32 Hash = 0;
+		TArray<uint8> Bytes;
+		for (UObject* Object : Objects)
+		{
+			Bytes.Reset();
+			FMemoryWriter MemoryWriter(Bytes);
+			FContentHashArchive Writer(MemoryWriter, Root);
+			Object->Serialize(Writer);
+			Hash = FCrc::StrCrc32(*Object->GetClass()->GetPathName(), Hash);
+			Hash = FCrc::StrCrc32(*Object->GetPathName(Root), Hash);
+			Hash = FCrc::MemCrc32(Bytes.GetData(), Bytes.Num(), Hash);
+		}
+		return Hash;
+	}
+}
+
 void FActionNodeRootSeacher::SearchImpl(UEdGraphNode* Node)
 {
 	if (Visited.Contains(Node))
@@ -441,6 +496,71 @@ void FGameActionCompilerContext::CreateFunctionList()
 	}
 }
 
+void FGameActionCompilerContext::MoveSequenceToLazyPackage(UGameActionSegment* Segment, const FName& RefVarName)
+{
+	UGameActionSequence* Sequence = Segment->GameActionSequence;
+	const FString PackageName = FString::Printf(TEXT("%s_%s"), *Blueprint->GetOutermost()->GetName(), *RefVarName.ToString());
+	const FName AssetName = *FPackageName::GetShortName(PackageName);
+
+	UPackage* SequencePackage = FindPackage(nullptr, *PackageName);
+	if (SequencePackage)
+	{
+		SequencePackage->FullyLoad();
+	}
+	else if (FPackageName::DoesPackageExist(PackageName))
+	{
+		SequencePackage = LoadPackage(nullptr, *PackageName, LOAD_None);
+	}
+	UObject* OldSequence = SequencePackage ? StaticFindObjectFast(nullptr, SequencePackage, AssetName) : nullptr;
+
+	const auto DiscardSequence = [](UObject* DiscardedSequence)
+	{
+		DiscardedSequence->ClearFlags(RF_Public | RF_Standalone);
+		DiscardedSequence->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty | REN_ForceNoResetLoaders);
+		DiscardedSequence->MarkPendingKill();
+	};
+
+	// 内容未变化时继续引用已保存的序列，不修改资源包
+	if (OldSequence && OldSequence->IsA<UGameActionSequence>() && GameActionCompilerUtils::ComputeContentHash(OldSequence) == GameActionCompilerUtils::ComputeContentHash(Sequence))
+	{
+		DiscardSequence(Sequence);
+		Segment->GameActionSequence = nullptr;
+		Segment->LazyGameActionSequence = CastChecked<UGameActionSequence>(OldSequence);
+		return;
+	}
+
+	// 命令行与打包时不创建或修改资源包，序列仍内嵌在类中，保证打包的数据与蓝图一致
+	if (IsRunningCommandlet() || GIsCookerLoadingPackage)
+	{
+		MessageLog.Warning(TEXT("延迟加载序列[%s]与蓝图不一致，本次以内嵌序列编译，请在编辑器中重新编译并保存"), *PackageName);
+		Segment->bLazyLoadSequence = false;
+		Segment->LazyGameActionSequence.Reset();
+		return;
+	}
+
+	if (SequencePackage == nullptr)
+	{
+		SequencePackage = CreatePackage(*PackageName);
+	}
+	// 旧的序列移至临时包中等待回收
+	if (OldSequence)
+	{
+		DiscardSequence(OldSequence);
+	}
+
+	Sequence->Rename(*AssetName.ToString(), SequencePackage, REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty | REN_ForceNoResetLoaders);
+	Sequence->ClearFlags(RF_DefaultSubObject);
+	Sequence->SetFlags(RF_Public | RF_Standalone | RF_Transactional);
+	SequencePackage->MarkPackageDirty();
+	if (OldSequence == nullptr)
+	{
+		FAssetRegistryModule::AssetCreated(Sequence);
+	}
+
+	Segment->GameActionSequence = nullptr;
+	Segment->LazyGameActionSequence = Sequence;
+}
+
 void FGameActionCompilerContext::OnPostCDOCompiled()
 {
 	Super::OnPostCDOCompiled();
@@ -479,6 +599,12 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 			}
 		}
 
+		// 预先解析为引用的生成物所对应的属性，运行时生成不再按名字查找
+		const auto ResolveSpawnableReference = [GameActionInstanceClass](UGameActionSequenceSpawnerSettingsBase* SpawnerSettings, const FMovieSceneSpawnable& Spawnable)
+		{
+			SpawnerSettings->ReferenceProperty = SpawnerSettings->bAsReference ? FindFProperty<FObjectProperty>(GameActionInstanceClass, Spawnable.GetObjectTemplate()->GetFName()) : nullptr;
+		};
+
 		TMap<FName, UGameActionSegmentBase*> InstanceMap;
 		for (UBPNode_GameActionSegmentBase* GameActionSegmentNode : ActionNodeRootSeacher.ActionNodes)
 		{
@@ -489,20 +615,37 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 			UClass* ActionClass = GameActionSegmentNode->GameActionSegment->GetClass();
 			const FName RefVarName = GameActionSegmentNode->GetRefVarName();
 
-			// 先把旧的Segment删除
+			// 内容未变化时复用上次编译的Segment，只有变化的片段才重新复制
+			const uint32 ContentHash = GameActionCompilerUtils::ComputeContentHash(GameActionSegmentNode->GameActionSegment);
+			UGameActionSegmentBase* GameActionSegmentTemplate = nullptr;
 			if (UGameActionSegmentBase* GameActionSegment = FindObjectFast<UGameActionSegmentBase>(GameActionInstanceCDO, RefVarName))
 			{
 				UBlueprint::ForceLoad(GameActionSegment);
 				GameActionSegment->ConditionalPostLoad();
-				GameActionSegment->MarkPendingKill();
-				GameActionSegment->ConditionalBeginDestroy();
+				if (GameActionSegment->GetClass() == ActionClass && GameActionSegment->CompiledContentHash == ContentHash)
+				{
+					GameActionSegmentTemplate = GameActionSegment;
+					GameActionSegmentTemplate->TickTransitions.Reset();
+					GameActionSegmentTemplate->EventTransitions.Reset();
+				}
+				else
+				{
+					// 先把旧的Segment删除
+					GameActionSegment->MarkPendingKill();
+					GameActionSegment->ConditionalBeginDestroy();
+				}
 			}
 
-			FObjectDuplicationParameters Parameters(GameActionSegmentNode->GameActionSegment, GameActionInstanceCDO);
-			Parameters.DestName = RefVarName;
-			Parameters.DestClass = GameActionSegmentNode->GameActionSegment->GetClass();
-			Parameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
-			UGameActionSegmentBase* GameActionSegmentTemplate = CastChecked<UGameActionSegmentBase>(::StaticDuplicateObjectEx(Parameters));
+			const bool bReuseTemplate = GameActionSegmentTemplate != nullptr;
+			if (bReuseTemplate == false)
+			{
+				FObjectDuplicationParameters Parameters(GameActionSegmentNode->GameActionSegment, GameActionInstanceCDO);
+				Parameters.DestName = RefVarName;
+				Parameters.DestClass = GameActionSegmentNode->GameActionSegment->GetClass();
+				Parameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
+				GameActionSegmentTemplate = CastChecked<UGameActionSegmentBase>(::StaticDuplicateObjectEx(Parameters));
+				GameActionSegmentTemplate->CompiledContentHash = ContentHash;
+			}
 			GameActionSegmentTemplate->BPNodeTemplate = GameActionSegmentNode;
 
 			FObjectProperty* ActionProperty = FindFProperty<FObjectProperty>(GameActionInstanceClass, RefVarName);
@@ -512,7 +655,36 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 			// 修改编译后的Spawnable的Outer为Class，因为Outer为Blueprint会导致打包后Template等丢失
 			if (UGameActionSegment* Segment = Cast<UGameActionSegment>(GameActionSegmentTemplate))
 			{
-				UMovieScene* MovieScene = Segment->GameActionSequence->GetMovieScene();
+				const bool bIsLazySequenceCompiled = bReuseTemplate && Segment->bLazyLoadSequence;
+				UGameActionSequence* CompiledSequence = bIsLazySequenceCompiled ? Segment->LazyGameActionSequence.LoadSynchronous() : Segment->GameActionSequence;
+				if (ensure(CompiledSequence) == false)
+				{
+					continue;
+				}
+				// 预先解析绑定，运行时不再按名字查找
+				CompiledSequence->CompileBindings(GameActionInstanceClass);
+
+				// 延迟加载的序列移至单独的资源包，类中只保留软引用，Spawnable模板随序列一同移动
+				UObject* SpawnableTemplateOuter = GameActionInstanceClass;
+				if (Segment->bLazyLoadSequence)
+				{
+					SpawnableTemplateOuter = CompiledSequence;
+				}
+				else
+				{
+					Segment->LazyGameActionSequence.Reset();
+				}
+
+				// 复用的模板可能在清理类时被移走，重新放回
+				const auto ReclaimTemplate = [&](UObject* Template)
+				{
+					if (Template->GetOuter() != SpawnableTemplateOuter)
+					{
+						Template->Rename(*Template->GetName(), SpawnableTemplateOuter, REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty | REN_ForceNoResetLoaders);
+					}
+				};
+
+				UMovieScene* MovieScene = CompiledSequence->GetMovieScene();
 				for (int32 Idx = 0; Idx < MovieScene->GetSpawnableCount(); ++Idx)
 				{
 					FMovieSceneSpawnable& Spawnable = MovieScene->GetSpawnable(Idx);
@@ -522,12 +694,19 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 						continue;
 					}
 
-					FObjectDuplicationParameters SpawnableParameters(Template, GameActionInstanceClass);
-					SpawnableParameters.DestName = Spawnable.GetObjectTemplate()->GetFName();
-					SpawnableParameters.DestClass = Spawnable.GetObjectTemplate()->GetClass();
-					SpawnableParameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
+					if (bReuseTemplate)
+					{
+						ReclaimTemplate(Template);
+					}
+					else
+					{
+						FObjectDuplicationParameters SpawnableParameters(Template, SpawnableTemplateOuter);
+						SpawnableParameters.DestName = Spawnable.GetObjectTemplate()->GetFName();
+						SpawnableParameters.DestClass = Spawnable.GetObjectTemplate()->GetClass();
+						SpawnableParameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
 
-					Spawnable.SetObjectTemplate(::StaticDuplicateObjectEx(SpawnableParameters));
+						Spawnable.SetObjectTemplate(::StaticDuplicateObjectEx(SpawnableParameters));
+					}
 
 					UGameActionDynamicSpawnTrack* SpawnTrack = MovieScene->FindTrack<UGameActionDynamicSpawnTrack>(Spawnable.GetGuid());
 					if (ensure(SpawnTrack && SpawnTrack->SpawnSection.Num() == 1))
@@ -537,12 +716,20 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 							UGameActionSequenceSpawnerSettings* SpawnerSettings = SpawnByTemplateSection->SpawnerSettings;
 							if (ensure(SpawnerSettings))
 							{
-								FObjectDuplicationParameters CustomSpawnerParameters(SpawnerSettings, GameActionInstanceClass);
-								CustomSpawnerParameters.DestName = SpawnerSettings->GetFName();
-								CustomSpawnerParameters.DestClass = SpawnerSettings->GetClass();
-								CustomSpawnerParameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
+								if (bReuseTemplate)
+								{
+									ReclaimTemplate(SpawnerSettings);
+								}
+								else
+								{
+									FObjectDuplicationParameters CustomSpawnerParameters(SpawnerSettings, SpawnableTemplateOuter);
+									CustomSpawnerParameters.DestName = SpawnerSettings->GetFName();
+									CustomSpawnerParameters.DestClass = SpawnerSettings->GetClass();
+									CustomSpawnerParameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
 
-								SpawnByTemplateSection->SpawnerSettings = CastChecked<UGameActionSequenceSpawnerSettings>(::StaticDuplicateObjectEx(CustomSpawnerParameters));
+									SpawnByTemplateSection->SpawnerSettings = CastChecked<UGameActionSequenceSpawnerSettings>(::StaticDuplicateObjectEx(CustomSpawnerParameters));
+								}
+								ResolveSpawnableReference(SpawnByTemplateSection->SpawnerSettings, Spawnable);
 							}
 						}
 						else if (UGameActionSpawnBySpawnerSection* SpawnBySpawnerSection = Cast<UGameActionSpawnBySpawnerSection>(SpawnTrack->SpawnSection[0]))
@@ -550,21 +737,36 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 							UGameActionSequenceCustomSpawnerBase* CustomSpawner = SpawnBySpawnerSection->CustomSpawner;
 							if (ensure(CustomSpawner))
 							{
-								FObjectDuplicationParameters CustomSpawnerParameters(CustomSpawner, GameActionInstanceClass);
-								CustomSpawnerParameters.DestName = CustomSpawner->GetFName();
-								CustomSpawnerParameters.DestClass = CustomSpawner->GetClass();
-								CustomSpawnerParameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
+								if (bReuseTemplate)
+								{
+									ReclaimTemplate(CustomSpawner);
+								}
+								else
+								{
+									FObjectDuplicationParameters CustomSpawnerParameters(CustomSpawner, SpawnableTemplateOuter);
+									CustomSpawnerParameters.DestName = CustomSpawner->GetFName();
+									CustomSpawnerParameters.DestClass = CustomSpawner->GetClass();
+									CustomSpawnerParameters.ApplyFlags = RF_Transactional | RF_DefaultSubObject | RF_Public;
 
-								SpawnBySpawnerSection->CustomSpawner = CastChecked<UGameActionSequenceCustomSpawnerBase>(::StaticDuplicateObjectEx(CustomSpawnerParameters));
+									SpawnBySpawnerSection->CustomSpawner = CastChecked<UGameActionSequenceCustomSpawnerBase>(::StaticDuplicateObjectEx(CustomSpawnerParameters));
+								}
+								ResolveSpawnableReference(SpawnBySpawnerSection->CustomSpawner, Spawnable);
 							}
 						}
 					}
 				}
+
+				// 序列内容处理完后再移动，以便与已保存的序列比较内容
+				if (Segment->bLazyLoadSequence && bIsLazySequenceCompiled == false)
+				{
+					MoveSequenceToLazyPackage(Segment, RefVarName);
+				}
 			}
 
 			// 添加输入变量结算函数
 			{
 				const FName EvaluateExposedInputsEventName = *FString::Printf(TEXT("%s_EvaluateExposedInputsEvent"), *GameActionSegmentNode->GetRefVarName().ToString());
+				GameActionSegmentTemplate->EvaluateExposedInputsEvent.Unbind();
 				if (UFunction* EventFunction = FindUField<UFunction>(GameActionInstanceClass, EvaluateExposedInputsEventName))
 				{
 					GameActionSegmentTemplate->EvaluateExposedInputsEvent.BindUFunction(GameActionInstanceCDO, EvaluateExposedInputsEventName);
@@ -577,6 +779,7 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 				if (It->GetBoolMetaData(TEXT("GameActionSegmentEvent")))
 				{
 					const FName EventName = *FString::Printf(TEXT("%s_%s"), *RefVarName.ToString(), *It->GetName());
+					It->ContainerPtrToValuePtr<FScriptDelegate>(GameActionSegmentTemplate)->Unbind();
 					if (UFunction* EventFunction = FindUField<UFunction>(GameActionInstanceClass, EventName))
 					{
 						It->ContainerPtrToValuePtr<FScriptDelegate>(GameActionSegmentTemplate)->BindUFunction(GameActionInstanceCDO, EventName);
@@ -601,6 +804,7 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 					TickTransition.Condition.BindUFunction(GameActionInstanceCDO, Data.Condition);
 					check(TickTransition.Condition.IsBound());
 				}
+				TickTransition.Dependency = Data.Dependency;
 			}
 			check(GameActionSegmentTemplate->EventTransitions.Num() == 0);
 			TransitionData.EventDatas.Sort([](const FTransitionData::FEventData& LHS, const FTransitionData::FEventData& RHS) { return LHS.Order < RHS.Order; });
@@ -737,17 +941,27 @@ void FGameActionCompilerContext::OnPostCDOCompiled()
 					{
 						SequenceOverride = Override->SequenceOverride;
 					}
+					else if (ParentActionSequenceTemplate->bLazyLoadSequence)
+					{
+						// 父类的延迟加载序列直接共享软引用
+						ActionSequenceTemplate->LazyGameActionSequence = ParentActionSequenceTemplate->LazyGameActionSequence;
+						continue;
+					}
 					else
 					{
 						SequenceOverride = ParentActionSequenceTemplate->GameActionSequence;
 					}
 
+					// 子类覆盖的序列不使用延迟加载
+					ActionSequenceTemplate->bLazyLoadSequence = false;
+					ActionSequenceTemplate->LazyGameActionSequence.Reset();
 					if (ensure(SequenceOverride))
 					{
 						FObjectDuplicationParameters Parameters(SequenceOverride, ActionTemplate);
 						Parameters.DestClass = SequenceOverride->GetClass();
 						Parameters.ApplyFlags = RF_Transactional | RF_Public;
 						ActionSequenceTemplate->GameActionSequence = CastChecked<UGameActionSequence>(::StaticDuplicateObjectEx(Parameters));
+						ActionSequenceTemplate->GameActionSequence->CompileBindings(GameActionInstanceClass);
 					}
 				}
 			}
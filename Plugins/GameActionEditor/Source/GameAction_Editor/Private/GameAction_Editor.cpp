@@ -11,6 +11,10 @@
 #include <EdGraphUtilities.h>
 #include <EditorModeRegistry.h>
 #include <ContentBrowserModule.h>
+#include <Editor.h>
+#include <FileHelpers.h>
+#include <TimerManager.h>
+#include <UObject/UObjectHash.h>
 
 #include "Editor/GameActionEdMode.h"
 #include "Blueprint/BPNode_GameActionTransition.h"
@@ -21,12 +25,16 @@
 #include "GameAction/GameActionSceneEditor.h"
 #include "GameAction/GameActionDetailCustomization.h"
 #include "GameAction/GameActionType.h"
+#include "GameAction/GameActionSegment.h"
+#include "GameAction/GameActionInstance.h"
+#include "Sequence/GameActionSequence.h"
 #include "Sequencer/GameActionEventTrackEditor.h"
 #include "Sequence/GameActionEventTrack.h"
 #include "Sequencer/GameActionAnimationTrackEditor.h"
 #include "Sequencer/GameActionTimeTestingTrackEditor.h"
 #include "Sequencer/GameActionSpawnTrackEditor.h"
 #include "Sequencer/GameActionTrackEditorHack.h"
+#include "Utils/GameAction_Log.h"
 
 #define LOCTEXT_NAMESPACE "FGameAction_EditorModule"
 
@@ -154,6 +162,8 @@ void FGameAction_EditorModule::StartupModule()
 	}
 	
 	FGameActionEditorCommands::Register();
+
+	PackageSavedHandle = UPackage::PackageSavedEvent.AddRaw(this, &FGameAction_EditorModule::WhenPackageSaved);
 }
 
 void FGameAction_EditorModule::ShutdownModule()
@@ -209,6 +219,69 @@ void FGameAction_EditorModule::ShutdownModule()
 	}
 	
 	FGameActionEditorCommands::Unregister();
+
+	UPackage::PackageSavedEvent.Remove(PackageSavedHandle);
+}
+
+void FGameAction_EditorModule::WhenPackageSaved(const FString& PackageFileName, UObject* Outer)
+{
+	UPackage* Package = Cast<UPackage>(Outer);
+	if (Package == nullptr || GEditor == nullptr || IsRunningCommandlet())
+	{
+		return;
+	}
+
+	TArray<UObject*> PackageObjects;
+	GetObjectsWithOuter(Package, PackageObjects, false);
+	UObject** BlueprintPtr = PackageObjects.FindByPredicate([](UObject* E) { return E->IsA<UGameActionBlueprint>(); });
+	const UGameActionBlueprint* GameActionBlueprint = BlueprintPtr ? CastChecked<UGameActionBlueprint>(*BlueprintPtr) : nullptr;
+	const UClass* GeneratedClass = GameActionBlueprint ? GameActionBlueprint->GeneratedClass : nullptr;
+	if (GeneratedClass == nullptr)
+	{
+		return;
+	}
+
+	// 延迟加载的序列在编译时移入单独的资源包，蓝图保存时一并保存，否则蓝图引用的序列在磁盘上不存在或是旧的
+	TArray<TWeakObjectPtr<UPackage>> DirtySequencePackages;
+	const UObject* GameActionInstanceCDO = GeneratedClass->GetDefaultObject();
+	for (TFieldIterator<FObjectProperty> It(GeneratedClass); It; ++It)
+	{
+		if (It->PropertyClass == nullptr || It->PropertyClass->IsChildOf<UGameActionSegment>() == false || It->GetBoolMetaData(UGameActionBlueprint::MD_GameActionTemplateReference) == false)
+		{
+			continue;
+		}
+		const UGameActionSegment* Segment = *It->ContainerPtrToValuePtr<UGameActionSegment*>(GameActionInstanceCDO);
+		const UGameActionSequence* LazySequence = Segment ? Segment->LazyGameActionSequence.Get() : nullptr;
+		UPackage* SequencePackage = LazySequence ? LazySequence->GetOutermost() : nullptr;
+		if (SequencePackage && SequencePackage != Package && SequencePackage->IsDirty())
+		{
+			DirtySequencePackages.AddUnique(SequencePackage);
+		}
+	}
+	if (DirtySequencePackages.Num() == 0)
+	{
+		return;
+	}
+
+	// 保存过程中不能嵌套保存，下一帧再保存
+	GEditor->GetTimerManager()->SetTimerForNextTick([DirtySequencePackages]()
+	{
+		TArray<UPackage*> PackagesToSave;
+		for (const TWeakObjectPtr<UPackage>& SequencePackage : DirtySequencePackages)
+		{
+			if (SequencePackage.IsValid() && SequencePackage->IsDirty())
+			{
+				PackagesToSave.Add(SequencePackage.Get());
+			}
+		}
+		if (PackagesToSave.Num() > 0 && FEditorFileUtils::PromptForCheckoutAndSave(PackagesToSave, false, false) != FEditorFileUtils::PR_Success)
+		{
+			for (const UPackage* SequencePackage : PackagesToSave)
+			{
+				GameAction_Log(Error, "蓝图保存时延迟加载序列的资源包[%s]保存失败，请手动保存", *SequencePackage->GetName());
+			}
+		}
+	});
 }
 
 void FGameAction_EditorModule::RegisterPossessableData(const TSubclassOf<AActor>& Type, const TSharedRef<FCustomPossessableActorDataFactory>& Factory)
@@ -40,6 +40,7 @@
 #include <EditorViewportClient.h>
 #include <Framework/Application/SlateApplication.h>
 #include <PropertyHandle.h>
+#include <HAL/IConsoleManager.h>
 
 #include "Editor/GameActionPreviewScene.h"
 #include "Sequence/GameActionSequence.h"
@@ -56,6 +57,11 @@
 
 #define LOCTEXT_NAMESPACE "Game Action Sequencer"
 
+static TAutoConsoleVariable<int32> CVarGameActionSequencerSessionCacheSize(
+	TEXT("GameAction.SequencerSessionCacheSize"),
+	5,
+	TEXT("GameAction编辑器中每个蓝图缓存的片段Sequencer会话数量，切换回已缓存的片段时无需重建Sequencer"));
+
 FGameActionSequencer::FGameActionSequencer(const TSharedRef<FGameActionEditScene>& InGameActionPreviewScene, const TSharedPtr<IToolkitHost>& InToolkitHost)
 	: ToolkitHost(InToolkitHost), EditScene(InGameActionPreviewScene), WidgetSectionVisual(*NewObject<UGameActionSequencerWidgetSectionVisual>())
 {
@@ -629,9 +635,10 @@ FGameActionSequencer::FGameActionSequencer(const TSharedRef<FGameActionEditScene
 				{
 					EditScene->PreviewOwner = CastChecked<ACharacter>(Pair.Value);
 					EditScene->CreatePreviewInstance();
-					if (UBPNode_GameActionSegment* SegmentNode = PreviewActionSegmentNode.Get())
+					UBPNode_GameActionSegment* SegmentNode = PreviewActionSegmentNode.Get();
+					ClearSequencerSessions();
+					if (SegmentNode)
 					{
-						CloseGameActionSequencer();
 						OpenGameActionSequencer(SegmentNode);
 					}
 					break;
@@ -643,10 +650,7 @@ FGameActionSequencer::FGameActionSequencer(const TSharedRef<FGameActionEditScene
 
 FGameActionSequencer::~FGameActionSequencer()
 {
-	if (PreviewActionSegmentNode.IsValid())
-	{
-		CloseGameActionSequencer();
-	}
+	ClearSequencerSessions();
 	if (ISequencerModule* SequencerModule = FModuleManager::LoadModulePtr<ISequencerModule>("Sequencer"))
 	{
 		SequencerModule->UnRegisterEditorObjectBinding(ActorBindingDelegateHandle);
@@ -955,7 +959,6 @@ void FGameActionSequencer::OpenGameActionSequencer(UBPNode_GameActionSegment* Ac
 	{
 		CloseGameActionSequencer();
 	}
-	PreviewActionSegmentNode = ActionSegmentNode;
 
 	bool IsEditable = EditScene->GameActionBlueprint->IsRootBlueprint();
 	UGameActionSequence* ShowSequence = GameActionSegment->GameActionSequence;
@@ -974,10 +977,20 @@ void FGameActionSequencer::OpenGameActionSequencer(UBPNode_GameActionSegment* Ac
 			}
 		}
 	}
-	if (IsEditable)
+
+	// 命中缓存时直接切换，避免重建Sequencer与复制预览Actor
+	const int32 SessionIdx = SequencerSessions.IndexOfByPredicate([&](const FSequencerSession& E) { return E.SegmentNode.Get() == ActionSegmentNode; });
+	if (SessionIdx != INDEX_NONE)
 	{
-		EditingActionSequence = ShowSequence;
-		ShowSequence->BelongToEditScene = EditScene;
+		FSequencerSession Session = SequencerSessions[SessionIdx];
+		SequencerSessions.RemoveAt(SessionIdx);
+		if (Session.Sequencer->GetRootMovieSceneSequence() == ShowSequence && Session.bIsEditable == IsEditable)
+		{
+			SequencerSessions.Add(Session);
+			ActivateSequencerSession(SequencerSessions.Last());
+			return;
+		}
+		Session.Sequencer->Close();
 	}
 
 	UGameActionInstanceBase* GameActionInstance = EditScene->GetGameActionInstance();
@@ -1024,14 +1037,6 @@ void FGameActionSequencer::OpenGameActionSequencer(UBPNode_GameActionSegment* Ac
 	SequencerSettings->SetInfiniteKeyAreas(true);
 	PreviewSequencer->SetPlaybackStatus(EMovieScenePlayerStatus::Stopped);
 
-	OnActorMoveHandle = GEditor->OnActorMoved().AddLambda([this](AActor* Actor)
-	{
-		if (Actor->GetWorld() == EditScene->GetWorld())
-		{
-			WhenPreviewObjectChanged(Actor);
-		}
-	});
-
 	// 选中Track时同步选中对应的Actor
 	PreviewSequencer->GetSelectionChangedObjectGuids().AddLambda([this](TArray<FGuid> ObjectGuids)
 	{
@@ -1191,8 +1196,14 @@ void FGameActionSequencer::OpenGameActionSequencer(UBPNode_GameActionSegment* Ac
 		}
 	});
 	PreviewSequencer->OnGlobalTimeChanged().AddSP(this, &FGameActionSequencer::SyncWidgetSectionPosition);
+	// 跳转时间与修改数据时补一次预览世界的更新
+	PreviewSequencer->OnGlobalTimeChanged().AddLambda([this]
+	{
+		EditScene->RequestWorldTick();
+	});
 	PreviewSequencer->OnMovieSceneDataChanged().AddLambda([this](EMovieSceneDataChangeType ChangeType)
 	{
+		EditScene->RequestWorldTick();
 		if (UGameActionBlueprint* GameActionBlueprint = EditScene->GameActionBlueprint)
 		{
 			GameActionBlueprint->Status = EBlueprintStatus::BS_Dirty;
@@ -1212,10 +1223,119 @@ void FGameActionSequencer::OpenGameActionSequencer(UBPNode_GameActionSegment* Ac
 		}
 	});
 
+	PreviewSequencer->GetSequencerWidget()->SetEnabled(IsEditable);
+
+	FSequencerSession& Session = SequencerSessions.AddDefaulted_GetRef();
+	Session.SegmentNode = ActionSegmentNode;
+	Session.Sequencer = PreviewSequencer;
+	Session.EditingSequence = IsEditable ? ShowSequence : nullptr;
+	Session.bIsEditable = IsEditable;
+
+	// 超出容量时淘汰最久未使用的会话
+	const int32 MaxSessionNum = FMath::Max(CVarGameActionSequencerSessionCacheSize.GetValueOnGameThread(), 1);
+	while (SequencerSessions.Num() > MaxSessionNum)
+	{
+		SequencerSessions[0].Sequencer->Close();
+		SequencerSessions.RemoveAt(0);
+	}
+	ActivateSequencerSession(SequencerSessions.Last());
+}
+
+void FGameActionSequencer::ActivateSequencerSession(FSequencerSession& Session)
+{
+	PreviewActionSegmentNode = Session.SegmentNode;
+	PreviewSequencer = Session.Sequencer;
+	EditingActionSequence = Session.EditingSequence;
+	if (UGameActionSequence* EditingSequence = EditingActionSequence.Get())
+	{
+		EditingSequence->BelongToEditScene = EditScene;
+	}
+
+	for (const TWeakObjectPtr<AActor>& HiddenActor : Session.HiddenActors)
+	{
+		if (AActor* Actor = HiddenActor.Get())
+		{
+			Actor->SetIsTemporarilyHiddenInEditor(false);
+		}
+	}
+	Session.HiddenActors.Empty();
+
+	OnActorMoveHandle = GEditor->OnActorMoved().AddLambda([this](AActor* Actor)
+	{
+		if (Actor->GetWorld() == EditScene->GetWorld())
+		{
+			WhenPreviewObjectChanged(Actor);
+		}
+	});
+	// 预览世界仅在播放或拖动时间轴时实时更新
+	EditScene->IsSequencerPlaying.BindLambda([this]
+	{
+		return PreviewSequencer.IsValid() && PreviewSequencer->GetPlaybackStatus() != EMovieScenePlayerStatus::Stopped;
+	});
+
 	ActionSequencerWidget->SetActiveWidgetIndex(1);
-	TSharedRef<SWidget> SequencerWidget = PreviewSequencer->GetSequencerWidget();
-	SequencerWidget->SetEnabled(IsEditable);
-	SequencerContent->SetContent(SequencerWidget);
+	SequencerContent->SetContent(PreviewSequencer->GetSequencerWidget());
+
+	PreviewSequencer->ForceEvaluate();
+	EditScene->RequestWorldTick();
+}
+
+void FGameActionSequencer::DeactivateSequencerSession(FSequencerSession& Session)
+{
+	ISequencer& Sequencer = *Session.Sequencer;
+	Sequencer.SetPlaybackStatus(EMovieScenePlayerStatus::Stopped);
+
+	const FGameActionSpawnRegister& SpawnRegister = static_cast<const FGameActionSpawnRegister&>(Sequencer.GetSpawnRegister());
+	TSet<AActor*> SpawnedActors;
+	for (const TPair<TWeakObjectPtr<AActor>, const UGameActionSequenceSpawnerSettingsBase*>& Pair : SpawnRegister.GetSpawnOwnershipMap())
+	{
+		if (AActor* Actor = Pair.Key.Get())
+		{
+			SpawnedActors.Add(Actor);
+		}
+	}
+
+	// 只还原对共享预览对象（如Owner）的修改，不能整体还原：生成轨道的还原令牌会销毁会话生成的预览Actor
+	UMovieScene* MovieScene = Sequencer.GetRootMovieSceneSequence()->GetMovieScene();
+	for (int32 Idx = 0; Idx < MovieScene->GetPossessableCount(); ++Idx)
+	{
+		for (TWeakObjectPtr<> BoundObject : Sequencer.FindBoundObjects(MovieScene->GetPossessable(Idx).GetGuid(), MovieSceneSequenceID::Root))
+		{
+			UObject* Object = BoundObject.Get();
+			if (Object == nullptr)
+			{
+				continue;
+			}
+			AActor* OwningActor = Object->IsA<AActor>() ? CastChecked<AActor>(Object) : Object->GetTypedOuter<AActor>();
+			if (SpawnedActors.Contains(OwningActor) == false)
+			{
+				Sequencer.PreAnimatedState.RestorePreAnimatedState(Sequencer, *Object);
+			}
+		}
+	}
+
+	// 会话生成的预览Actor隐藏后保留，再次切换回来时直接显示
+	for (AActor* Actor : SpawnedActors)
+	{
+		if (::IsValid(Actor) && Actor->IsTemporarilyHiddenInEditor() == false)
+		{
+			Actor->SetIsTemporarilyHiddenInEditor(true);
+			Session.HiddenActors.Add(Actor);
+		}
+	}
+}
+
+void FGameActionSequencer::ClearSequencerSessions()
+{
+	if (PreviewActionSegmentNode.IsValid() || PreviewSequencer.IsValid())
+	{
+		CloseGameActionSequencer();
+	}
+	for (const FSequencerSession& Session : SequencerSessions)
+	{
+		Session.Sequencer->Close();
+	}
+	SequencerSessions.Empty();
 }
 
 void FGameActionSequencer::CloseGameActionSequencer()
@@ -1230,9 +1350,19 @@ void FGameActionSequencer::CloseGameActionSequencer()
 	}
 	if (PreviewSequencer.IsValid())
 	{
-		PreviewSequencer->Close();
+		// 会话保留在缓存中，再次打开同一节点时可直接切换
+		if (FSequencerSession* Session = SequencerSessions.FindByPredicate([&](const FSequencerSession& E) { return E.Sequencer == PreviewSequencer; }))
+		{
+			DeactivateSequencerSession(*Session);
+		}
+		else
+		{
+			PreviewSequencer->Close();
+		}
 		PreviewSequencer = nullptr;
 	}
+	EditingActionSequence = nullptr;
+	EditScene->IsSequencerPlaying.Unbind();
 	GEditor->OnActorMoved().Remove(OnActorMoveHandle);
 	ActionSequencerWidget->SetActiveWidgetIndex(0);
 	SequencerContent->SetContent(SNullWidget::NullWidget);
@@ -1259,11 +1389,20 @@ void FGameActionSequencer::WhenDeleteNode(UBPNode_GameActionSegmentBase* GameAct
 	{
 		CloseGameActionSequencer();
 	}
+	const int32 SessionIdx = SequencerSessions.IndexOfByPredicate([&](const FSequencerSession& E) { return E.SegmentNode.Get() == GameActionSegmentNode; });
+	if (SessionIdx != INDEX_NONE)
+	{
+		SequencerSessions[SessionIdx].Sequencer->Close();
+		SequencerSessions.RemoveAt(SessionIdx);
+	}
 }
 
 void FGameActionSequencer::PostBlueprintCompiled()
 {
-	if (UBPNode_GameActionSegment* ActionSegmentNode = PreviewActionSegmentNode.Get())
+	// 编译后序列与模板可能被替换，缓存的会话全部失效
+	UBPNode_GameActionSegment* ActionSegmentNode = PreviewActionSegmentNode.Get();
+	ClearSequencerSessions();
+	if (ActionSegmentNode)
 	{
 		OpenGameActionSequencer(ActionSegmentNode);
 	}
@@ -106,6 +106,12 @@ public:
 		Actived
 	};
 	EDebugState DebugState = EDebugState::Deactived;
+	// 调试轨迹中的序号，0为最近激活，不在轨迹中时为INDEX_NONE
+	int32 DebugTrailIndex = INDEX_NONE;
+	// 调试轨迹最多记录的片段数
+	static constexpr int32 MaxDebugTrailNum = 8;
+	float DebugActivedTime = 0.f;
+	float DebugTimeSpent = 0.f;
 };
 
 UCLASS()
@@ -14,6 +14,7 @@
  */
 class UGameActionSegmentBase;
 class UBPNode_GameActionSegmentBase;
+struct FGameActionTransitionDependency;
 
 namespace GameActionTransitionResultUtils
 {
@@ -107,6 +108,8 @@ public:
     UEdGraphPin* GetToPin() const { return FindPinChecked(UEdGraphSchema_K2::PN_Then)->LinkedTo[0]; }
 	virtual FName GetTransitionName() const { return NAME_None; }
 	void UpdateBoundGraphName();
+	// 分析本地判断的跳转条件读取了哪些数据，存在无法分析的节点时标记为未知依赖
+	FGameActionTransitionDependency AnalyzeConditionDependency() const;
 public:
     const static FLinearColor HoverColor;
 	const static FLinearColor BaseColor;
@@ -5,10 +5,13 @@
 #include "CoreMinimal.h"
 #include <BlueprintEditor.h>
 
+#include "Utils/GameActionDebugEvents.h"
+
 class UGameActionBlueprint;
 class FGameActionSequencer;
 class FGameActionEditScene;
 class FGameActionSimulateScene;
+class UGameActionInstanceBase;
 
 /**
  * 
@@ -70,7 +73,23 @@ private:
         void Tick(float DeltaTime) override;
 
         FGameActionEditor& GameActionEditor;
-    	TWeakObjectPtr<class UBPNode_GameActionSegmentBase> PreActicedNode;
+    	// 运行时发布的片段激活事件，同一帧内激活又结束的片段也能记录
+    	FGameActionDebugEventListener DebugEventListener;
+    	TWeakObjectPtr<UGameActionInstanceBase> DebugInstance;
+
+    	// 最近的跳转轨迹，首个元素为最近激活的片段
+    	struct FTrailRecord
+    	{
+    		TWeakObjectPtr<class UBPNode_GameActionSegmentBase> Node;
+    		float ActivedTime = 0.f;
+    		// 小于0表示仍处于激活状态
+    		float DeactivedTime = -1.f;
+    	};
+    	TArray<FTrailRecord> Trail;
+    	static constexpr int32 MaxTrailNum = UBPNode_GameActionSegmentBase::MaxDebugTrailNum;
+    	TArray<TWeakObjectPtr<class UBPNode_GameActionSegmentBase>> DisplayedNodes;
+    	void ResetTrail();
+    	void UpdateNodeDebugStates(float WorldTime);
     };
     FGameActionDebugger GameActionDebugger;
 };
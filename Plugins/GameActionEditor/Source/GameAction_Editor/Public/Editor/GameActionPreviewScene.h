@@ -24,6 +24,11 @@ public:
 
 	void Tick(float DeltaTime) override;
 
+	// 请求下一帧更新一次预览世界，用于空闲时编辑后刷新画面
+	void RequestWorldTick() { bWorldTickRequested = true; }
+	// 暂停预览世界的更新，例如编辑场景在模拟期间不可见
+	uint8 bSuspendWorldTick : 1;
+
 	UGameActionInstanceBase* GetGameActionInstance() const { return PreviewInstance; }
 	UGameActionComponent* GetGameActionComponent() const { return GameActionComponent; }
 	UGameActionBlueprint* GameActionBlueprint = nullptr;
@@ -43,6 +48,12 @@ public:
 protected:
 	UGameActionInstanceBase* PreviewInstance = nullptr;
 	UGameActionComponent* GameActionComponent = nullptr;
+
+	// 为真时每帧更新预览世界，否则按GameAction.PreviewIdleTickRate降频更新
+	virtual bool IsRealtimeWorldTick() const { return true; }
+private:
+	uint8 bWorldTickRequested : 1;
+	float PendingIdleDeltaTime = 0.f;
 };
 
 class FGameActionEditScene : public FGameActionPreviewScene
@@ -62,6 +73,12 @@ public:
 	FOnMoveToViewActor OnMoveViewActor;
 
 	TWeakObjectPtr<AActor> CameraCutsViewActor;
+
+	// Sequencer播放或拖动时间轴时返回真
+	DECLARE_DELEGATE_RetVal(bool, FIsSequencerPlaying);
+	FIsSequencerPlaying IsSequencerPlaying;
+protected:
+	bool IsRealtimeWorldTick() const override { return IsSequencerPlaying.IsBound() && IsSequencerPlaying.Execute(); }
 private:
 	TWeakObjectPtr<UObject> DrawableObject;
 	TWeakObjectPtr<UObject> DrawableObjectOrigin;
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <Commandlets/Commandlet.h>
+#include "GameActionCommandlets.generated.h"
+
+/**
+ * 加载所有GameAction蓝图并输出内存报告
+ * 用法：-run=GameActionMemReport [-csv=保存路径]
+ */
+UCLASS()
+class GAMEACTION_EDITOR_API UGameActionMemReportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UGameActionMemReportCommandlet();
+
+	int32 Main(const FString& Params) override;
+};
+
+/**
+ * 编译并校验所有GameAction蓝图的编译数据，包括序列求值模板、绑定、生成器设置与跳转表
+ * 存在错误时返回非0，可用于持续集成
+ * 用法：-run=GameActionValidate
+ */
+UCLASS()
+class GAMEACTION_EDITOR_API UGameActionValidateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UGameActionValidateCommandlet();
+
+	int32 Main(const FString& Params) override;
+};
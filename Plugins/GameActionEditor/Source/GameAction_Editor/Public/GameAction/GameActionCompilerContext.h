@@ -4,12 +4,14 @@
 
 #include "CoreMinimal.h"
 #include <KismetCompiler.h>
+#include "GameAction/GameActionSegment.h"
 
 class UBPNode_GameActionTransitionBase;
 class UGameActionBlueprint;
 class UEdGraph_GameAction;
 class UBPNode_GameActionSegmentBase;
 class UBPNode_GameActionEntry;
+class UGameActionSegment;
 
 /**
  * 
@@ -47,6 +49,7 @@ public:
 			FName Condition;
 			FName SegmentName;
 			int32 Order;
+			FGameActionTransitionDependency Dependency;
 		};
 		TArray<FTickData> TickDatas;
 
@@ -60,4 +63,6 @@ public:
 		TArray<FEventData> EventDatas;
 	};
 	TMap<FName, FTransitionData> ActionTransitionDatas;
+private:
+	void MoveSequenceToLazyPackage(UGameActionSegment* Segment, const FName& RefVarName);
 };
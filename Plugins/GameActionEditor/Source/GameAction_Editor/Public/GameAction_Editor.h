@@ -43,6 +43,8 @@ private:
 	FDelegateHandle GameActionAnimationTrackEditorHandle;
 	FDelegateHandle GameActionTrackEditorHackHandle;
 	FDelegateHandle ContentBrowserExtenderDelegateHandle;
+	FDelegateHandle PackageSavedHandle;
+	void WhenPackageSaved(const FString& PackageFileName, UObject* Outer);
 
 	friend class FGameActionEditorStyle;
 	FGameActionEditorStyle GameActionEditorStyle;
@@ -57,6 +57,21 @@ protected:
 	FDelegateHandle SequenceEditorHandle;
 	FDelegateHandle OnActorMoveHandle;
 	FDelegateHandle OnObjectsReplacedHandle;
+
+	// 按片段节点缓存的Sequencer会话，末尾为最近使用
+	struct FSequencerSession
+	{
+		TWeakObjectPtr<UBPNode_GameActionSegment> SegmentNode;
+		TSharedPtr<ISequencer> Sequencer;
+		TWeakObjectPtr<UGameActionSequence> EditingSequence;
+		bool bIsEditable = false;
+		// 切换走时隐藏的预览Actor
+		TArray<TWeakObjectPtr<AActor>> HiddenActors;
+	};
+	TArray<FSequencerSession> SequencerSessions;
+	void ActivateSequencerSession(FSequencerSession& Session);
+	void DeactivateSequencerSession(FSequencerSession& Session);
+	void ClearSequencerSessions();
 public:
 	class FGameActionDetailKeyframeHandler : public IDetailKeyframeHandler
 	{
@@ -28,6 +28,7 @@ public class GameAction_Runtime : ModuleRules
 				"Core",
                 "MovieScene",
                 "MovieSceneTracks",
+				"GameplayTags",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -40,6 +41,8 @@ public class GameAction_Runtime : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"Niagara",
+				"NetworkReplayStreaming",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
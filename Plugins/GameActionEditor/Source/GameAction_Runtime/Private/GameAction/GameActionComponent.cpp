@@ -5,8 +5,11 @@
 #include <Net/UnrealNetwork.h>
 #include <Engine/ActorChannel.h>
 #include <GameFramework/Character.h>
+#include <Engine/DemoNetDriver.h>
 
+#include "GameAction/GameActionEvent.h"
 #include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionReplay.h"
 #include "GameAction/GameActionSegment.h"
 #include "Sequence/GameActionSequencePlayer.h"
 #include "Utils/GameAction_Log.h"
@@ -55,6 +58,7 @@ void UGameActionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 			ActionInstance->DeactiveInstance();
 		}
 	}
+	FlushReplay();
 }
 
 // Called every frame
@@ -68,6 +72,8 @@ void UGameActionComponent::TickComponent(float DeltaTime, ELevelTick TickType, F
 		SharedPlayer->Update(DeltaTime);
 	}
 	
+	TickReplay();
+
 	// 反向迭代，防止当ActionInstance在Tick过程中销毁自己导致漏迭代
 	for (int32 Idx = ActionInstances.Num() - 1; Idx >=0; --Idx)
 	{
@@ -80,12 +86,17 @@ void UGameActionComponent::GetLifetimeReplicatedProps(TArray<class FLifetimeProp
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(UGameActionComponent, ActionInstances);
+	DOREPLIFETIME_CONDITION(UGameActionComponent, ActionInstances, COND_SkipReplay);
 }
 
 bool UGameActionComponent::ReplicateSubobjects(class UActorChannel* Channel, class FOutBunch* Bunch, FReplicationFlags* RepFlags)
 {
 	bool WroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+	// 录像使用行为流记录，见GameActionReplay.h
+	if (RepFlags->bReplay)
+	{
+		return WroteSomething;
+	}
 	for (UGameActionInstanceBase* ActionInstance : ActionInstances)
 	{
 		ActionInstance->ReplicateSubobject(WroteSomething, Channel, Bunch, RepFlags);
@@ -297,3 +308,142 @@ void UGameActionComponent::AbortSharedPlayerActiveAction()
 		SharedPlayerAction->AbortGameAction();
 	}
 }
+
+UGameActionStateEvent* UGameActionComponent::AcquireStateEventInstance(const UGameActionStateEvent* Template)
+{
+	FGameActionStateEventPool& Pool = StateEventPools.FindOrAdd(Template);
+
+	UGameActionStateEvent* Instance = nullptr;
+	while (Instance == nullptr && Pool.FreeInstances.Num() > 0)
+	{
+		Instance = Pool.FreeInstances.Pop(false);
+	}
+
+	if (Instance)
+	{
+		Instance->ResetInstance(Template);
+	}
+	else
+	{
+		Instance = NewObject<UGameActionStateEvent>(this, Template->GetClass(), NAME_None, RF_NoFlags, const_cast<UGameActionStateEvent*>(Template));
+	}
+	Pool.UsedInstances.Add(Instance);
+	return Instance;
+}
+
+void UGameActionComponent::ReleaseStateEventInstance(const UGameActionStateEvent* Template, UGameActionStateEvent* Instance)
+{
+	if (FGameActionStateEventPool* Pool = StateEventPools.Find(Template))
+	{
+		if (Pool->UsedInstances.RemoveSingleSwap(Instance, false) > 0)
+		{
+			Pool->FreeInstances.Add(Instance);
+		}
+	}
+}
+
+uint32 UGameActionComponent::GameActionTagsSerial = 0;
+
+void UGameActionComponent::AddGameActionTags(const FGameplayTagContainer& Tags)
+{
+	for (const FGameplayTag& Tag : Tags)
+	{
+		int32& Count = GameActionTagCounts.FindOrAdd(Tag);
+		Count += 1;
+		if (Count == 1)
+		{
+			GameActionTags.AddTag(Tag);
+			GameActionTagsSerial += 1;
+		}
+	}
+}
+
+void UGameActionComponent::RemoveGameActionTags(const FGameplayTagContainer& Tags)
+{
+	for (const FGameplayTag& Tag : Tags)
+	{
+		int32* Count = GameActionTagCounts.Find(Tag);
+		if (Count == nullptr)
+		{
+			continue;
+		}
+		*Count -= 1;
+		if (*Count <= 0)
+		{
+			GameActionTagCounts.Remove(Tag);
+			GameActionTags.RemoveTag(Tag);
+			GameActionTagsSerial += 1;
+		}
+	}
+}
+
+void UGameActionComponent::RecordReplay(EGameActionReplayRecordType Type, UGameActionInstanceBase* Instance, UGameActionSegmentBase* Segment)
+{
+	UDemoNetDriver* DemoNetDriver = GetWorld()->GetDemoNetDriver();
+	if (DemoNetDriver && DemoNetDriver->IsRecording())
+	{
+		if (ReplayRecorder.IsValid() == false)
+		{
+			ReplayRecorder = MakeShared<FGameActionReplayRecorder>();
+		}
+		ReplayRecorder->Record(this, DemoNetDriver, Type, Instance, Segment);
+	}
+}
+
+UGameActionInstanceBase* UGameActionComponent::FindOrAddReplayInstance(const FString& ClassPath)
+{
+	UClass* ActionClass = FSoftClassPath(ClassPath).TryLoadClass<UGameActionInstanceBase>();
+	if (ActionClass == nullptr)
+	{
+		GameAction_Log(Warning, "录像中的行为[%s]加载失败", *ClassPath);
+		return nullptr;
+	}
+	if (UGameActionInstanceBase* ActionInstance = FindGameAction(ActionClass))
+	{
+		return ActionInstance;
+	}
+	UGameActionInstanceBase* ActionInstance = NewObject<UGameActionInstanceBase>(this, ActionClass, ActionClass->GetFName());
+	AddGameActionNoCheck(ActionInstance);
+	return ActionInstance;
+}
+
+void UGameActionComponent::FlushReplay()
+{
+	UDemoNetDriver* DemoNetDriver = GetWorld()->GetDemoNetDriver();
+	if (ReplayRecorder.IsValid() && DemoNetDriver && DemoNetDriver->IsRecording())
+	{
+		ReplayRecorder->Flush(DemoNetDriver);
+	}
+}
+
+void UGameActionComponent::TickReplay()
+{
+	UDemoNetDriver* DemoNetDriver = GetWorld()->GetDemoNetDriver();
+	if (DemoNetDriver == nullptr)
+	{
+		ReplayRecorder.Reset();
+		return;
+	}
+
+	if (DemoNetDriver->IsRecording())
+	{
+		if (ReplayRecorder.IsValid() == false)
+		{
+			ReplayRecorder = MakeShared<FGameActionReplayRecorder>();
+		}
+		ReplayRecorder->Tick(this, DemoNetDriver);
+	}
+	else if (DemoNetDriver->IsPlaying())
+	{
+		if (ReplayPlayback.IsValid() == false)
+		{
+			ReplayPlayback = MakeShared<FGameActionReplayPlayback>();
+		}
+		ReplayPlayback->Update(this, DemoNetDriver);
+	}
+	else
+	{
+		// 录制已停止，再次录制时重新开始
+		ReplayRecorder.Reset();
+	}
+}
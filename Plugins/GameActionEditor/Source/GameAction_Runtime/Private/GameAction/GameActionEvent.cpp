@@ -10,6 +10,7 @@
 #include "Utils/GameAction_Log.h"
 
 UGameActionEventBase::UGameActionEventBase()
+	: bNativeEvent(false)
 {
 #if WITH_EDITORONLY_DATA
 	bExecuteInEditor = false;
@@ -46,7 +47,11 @@ void UGameActionKeyEvent::ExecuteEvent(UObject* EventOwner, IMovieScenePlayer& P
 	{
 		return;
 	}
-	FEditorScriptExecutionGuard EditorScriptExecutionGuard;
+	TOptional<FEditorScriptExecutionGuard> EditorScriptExecutionGuard;
+	if (bNativeEvent == false)
+	{
+		EditorScriptExecutionGuard.Emplace();
+	}
 #endif
 	GameAction_Log(Display, "[%s] 执行帧事件 [%s]", *EventOwner->GetName(), *GetEventName());
 	WhenEventExecute(EventOwner, Player);
@@ -65,7 +70,11 @@ void UGameActionStateEvent::StartEvent(UObject* EventOwner, IMovieScenePlayer& P
 	{
 		return;
 	}
-	FEditorScriptExecutionGuard EditorScriptExecutionGuard;
+	TOptional<FEditorScriptExecutionGuard> EditorScriptExecutionGuard;
+	if (bNativeEvent == false)
+	{
+		EditorScriptExecutionGuard.Emplace();
+	}
 #endif
 	GameAction_Log(Display, "[%s] 开始状态事件 [%s]", *EventOwner->GetName(), *GetEventName());
 	WhenEventStart(EventOwner, Player);
@@ -79,7 +88,11 @@ void UGameActionStateEvent::TickEvent(UObject* EventOwner, IMovieScenePlayer& Pl
 	{
 		return;
 	}
-	FEditorScriptExecutionGuard EditorScriptExecutionGuard;
+	TOptional<FEditorScriptExecutionGuard> EditorScriptExecutionGuard;
+	if (bNativeEvent == false)
+	{
+		EditorScriptExecutionGuard.Emplace();
+	}
 #endif
 	WhenEventTick(EventOwner, Player, DeltaSeconds);
 }
@@ -92,12 +105,32 @@ void UGameActionStateEvent::EndEvent(UObject* EventOwner, IMovieScenePlayer& Pla
 	{
 		return;
 	}
-	FEditorScriptExecutionGuard EditorScriptExecutionGuard;
+	TOptional<FEditorScriptExecutionGuard> EditorScriptExecutionGuard;
+	if (bNativeEvent == false)
+	{
+		EditorScriptExecutionGuard.Emplace();
+	}
 #endif
 	GameAction_Log(Display, "[%s] 结束状态事件 [%s]", *EventOwner->GetName(), *GetEventName());
 	WhenEventEnd(EventOwner, Player, bIsCompleted);
 }
 
+void UGameActionStateEvent::ResetInstance(const UGameActionStateEvent* Template)
+{
+	// 非Transient的属性（包含蓝图变量）还原为模板的值，Transient的属性模板不会序列化，还原为类默认值
+	// 实例化引用的属性保留创建实例时复制出的子对象，复制模板的值会让实例与模板共享子对象
+	const UObject* ClassDefault = GetClass()->GetDefaultObject();
+	for (TFieldIterator<FProperty> It(GetClass()); It; ++It)
+	{
+		const FProperty* Property = *It;
+		if (Property->HasAnyPropertyFlags(CPF_InstancedReference | CPF_ContainsInstancedReference))
+		{
+			continue;
+		}
+		Property->CopyCompleteValue_InContainer(this, Property->HasAnyPropertyFlags(CPF_Transient) ? ClassDefault : Template);
+	}
+}
+
 void UGameActionStateEvent::WhenEventStart(UObject* EventOwner, IMovieScenePlayer& Player)
 {
 	ReceiveWhenEventStart(EventOwner, Cast<UGameActionInstanceBase>(Player.GetPlaybackContext()));
@@ -0,0 +1,287 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameAction/GameActionHitQuery.h"
+#include <Engine/World.h>
+#include <GameFramework/Actor.h>
+#include <Components/SceneComponent.h>
+#include <IMovieScenePlayer.h>
+
+#include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionNativeEventsUtils.h"
+
+UGameActionHitQuerySubsystem* UGameActionHitQuerySubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGameActionHitQuerySubsystem>() : nullptr;
+}
+
+FTraceHandle UGameActionHitQuerySubsystem::SubmitSweep(const FVector& Start, const FVector& End, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor)
+{
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(GameActionHitQuery), false, IgnoreActor);
+	return GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Multi, Start, End, Rotation, TraceChannel, Shape, Params);
+}
+
+FTraceHandle UGameActionHitQuerySubsystem::SubmitOverlap(const FVector& Location, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor)
+{
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(GameActionHitQuery), false, IgnoreActor);
+	return GetWorld()->AsyncOverlapByChannel(Location, Rotation, TraceChannel, Shape, Params);
+}
+
+namespace GameActionHitQuery
+{
+	void AppendOverlapHits(const TArray<FOverlapResult>& Overlaps, const FVector& Location, TArray<FHitResult>& OutHits)
+	{
+		OutHits.Reserve(OutHits.Num() + Overlaps.Num());
+		for (const FOverlapResult& Overlap : Overlaps)
+		{
+			FHitResult& Hit = OutHits.AddDefaulted_GetRef();
+			Hit.Actor = Overlap.Actor;
+			Hit.Component = Overlap.Component;
+			Hit.Item = Overlap.ItemIndex;
+			Hit.bBlockingHit = Overlap.bBlockingHit;
+			Hit.Location = Hit.ImpactPoint = Hit.TraceStart = Hit.TraceEnd = Location;
+		}
+	}
+}
+
+bool UGameActionHitQuerySubsystem::ConsumeResults(const FTraceHandle& Handle, bool bIsOverlap, TArray<FHitResult>& OutHits) const
+{
+	UWorld* World = GetWorld();
+	if (Handle.IsValid() == false || World->IsTraceHandleValid(Handle, bIsOverlap) == false)
+	{
+		return false;
+	}
+
+	if (bIsOverlap)
+	{
+		FOverlapDatum OverlapDatum;
+		if (World->QueryOverlapData(Handle, OverlapDatum) == false)
+		{
+			return false;
+		}
+		GameActionHitQuery::AppendOverlapHits(OverlapDatum.OutOverlaps, OverlapDatum.Pos, OutHits);
+	}
+	else
+	{
+		FTraceDatum TraceDatum;
+		if (World->QueryTraceData(Handle, TraceDatum) == false)
+		{
+			return false;
+		}
+		OutHits.Append(TraceDatum.OutHits);
+	}
+	return true;
+}
+
+void UGameActionHitQuerySubsystem::Sweep(const FVector& Start, const FVector& End, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor, TArray<FHitResult>& OutHits) const
+{
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(GameActionHitQuery), false, IgnoreActor);
+	TArray<FHitResult> Hits;
+	GetWorld()->SweepMultiByChannel(Hits, Start, End, Rotation, TraceChannel, Shape, Params);
+	OutHits.Append(Hits);
+}
+
+void UGameActionHitQuerySubsystem::Overlap(const FVector& Location, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor, TArray<FHitResult>& OutHits) const
+{
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(GameActionHitQuery), false, IgnoreActor);
+	TArray<FOverlapResult> Overlaps;
+	GetWorld()->OverlapMultiByChannel(Overlaps, Location, Rotation, TraceChannel, Shape, Params);
+	GameActionHitQuery::AppendOverlapHits(Overlaps, Location, OutHits);
+}
+
+UGameActionStateEvent_HitQuery::UGameActionStateEvent_HitQuery()
+	: bSweep(true), PendingFrame(0), bPendingIsOverlap(false), bHasPreviousLocation(false), PendingStartLocation(FVector::ZeroVector), PreviousLocation(FVector::ZeroVector), PendingRotation(FQuat::Identity)
+{
+	bNativeEvent = true;
+	// 命中列表与未完成的查询是每次激活独有的状态
+	bInstanced = true;
+}
+
+void UGameActionStateEvent_HitQuery::ResetInstance(const UGameActionStateEvent* Template)
+{
+	Super::ResetInstance(Template);
+	HitActors.Reset();
+	PendingHandle = FTraceHandle();
+	bHasPreviousLocation = false;
+}
+
+void UGameActionStateEvent_HitQuery::WhenEventStart(UObject* EventOwner, IMovieScenePlayer& Player)
+{
+	HitActors.Reset();
+	PendingHandle = FTraceHandle();
+	bHasPreviousLocation = false;
+	SubmitQuery(EventOwner);
+}
+
+void UGameActionStateEvent_HitQuery::WhenEventTick(UObject* EventOwner, IMovieScenePlayer& Player, float DeltaSeconds)
+{
+	// 同一帧内多次求值时上一次的查询还不可读，不提交新的查询，下一次提交从上一次的终点扫掠，不会漏掉这段位移
+	if (ConsumePendingQuery(EventOwner, Player))
+	{
+		SubmitQuery(EventOwner);
+	}
+}
+
+void UGameActionStateEvent_HitQuery::WhenEventEnd(UObject* EventOwner, IMovieScenePlayer& Player, bool bIsCompleted)
+{
+	FinalQuery(EventOwner, Player);
+	PendingHandle = FTraceHandle();
+	bHasPreviousLocation = false;
+}
+
+void UGameActionStateEvent_HitQuery::WhenHit(UObject* EventOwner, const FHitResult& Hit, IMovieScenePlayer& Player)
+{
+#if WITH_EDITOR
+	FEditorScriptExecutionGuard EditorScriptExecutionGuard;
+#endif
+	ReceiveWhenHit(EventOwner, Hit, Cast<UGameActionInstanceBase>(Player.GetPlaybackContext()));
+}
+
+bool UGameActionStateEvent_HitQuery::ConsumePendingQuery(UObject* EventOwner, IMovieScenePlayer& Player)
+{
+	if (PendingHandle.IsValid() == false)
+	{
+		return true;
+	}
+	if (GFrameCounter <= PendingFrame)
+	{
+		return false;
+	}
+	const FTraceHandle Handle = PendingHandle;
+	PendingHandle = FTraceHandle();
+
+	UGameActionHitQuerySubsystem* HitQuerySubsystem = UGameActionHitQuerySubsystem::Get(EventOwner);
+	if (HitQuerySubsystem == nullptr)
+	{
+		return true;
+	}
+	TArray<FHitResult> Results;
+	if (HitQuerySubsystem->ConsumeResults(Handle, bPendingIsOverlap, Results) == false)
+	{
+		// 超过一帧未取回的查询已被引擎回收，同FinalQuery一样同步重做这次查询，避免漏掉这段位移
+		const USceneComponent* QueryComponent = GameActionNativeEvents::GetAttachComponent(EventOwner);
+		const AActor* IgnoreActor = QueryComponent ? QueryComponent->GetOwner() : nullptr;
+		const FCollisionShape CollisionShape = MakeCollisionShape();
+		if (bPendingIsOverlap)
+		{
+			HitQuerySubsystem->Overlap(PreviousLocation, PendingRotation, TraceChannel, CollisionShape, IgnoreActor, Results);
+		}
+		else
+		{
+			HitQuerySubsystem->Sweep(PendingStartLocation, PreviousLocation, PendingRotation, TraceChannel, CollisionShape, IgnoreActor, Results);
+		}
+	}
+	DispatchHits(EventOwner, Player, Results);
+	return true;
+}
+
+void UGameActionStateEvent_HitQuery::FinalQuery(UObject* EventOwner, IMovieScenePlayer& Player)
+{
+	FVector Start = PreviousLocation;
+	if (ConsumePendingQuery(EventOwner, Player) == false)
+	{
+		// 结束时等不到下一帧，同步重做这次扫掠覆盖的位移，重叠查询的位置即为PreviousLocation
+		PendingHandle = FTraceHandle();
+		if (bPendingIsOverlap == false)
+		{
+			Start = PendingStartLocation;
+		}
+	}
+
+	UGameActionHitQuerySubsystem* HitQuerySubsystem = UGameActionHitQuerySubsystem::Get(EventOwner);
+	FVector Location;
+	FQuat Rotation;
+	const AActor* IgnoreActor;
+	if (HitQuerySubsystem == nullptr || GetQueryTransform(EventOwner, Location, Rotation, IgnoreActor) == false)
+	{
+		return;
+	}
+
+	// 补上最后一次提交至结束之间的位移
+	TArray<FHitResult> Results;
+	const FCollisionShape CollisionShape = MakeCollisionShape();
+	if (bSweep && bHasPreviousLocation)
+	{
+		HitQuerySubsystem->Sweep(Start, Location, Rotation, TraceChannel, CollisionShape, IgnoreActor, Results);
+	}
+	else
+	{
+		HitQuerySubsystem->Overlap(Location, Rotation, TraceChannel, CollisionShape, IgnoreActor, Results);
+	}
+	DispatchHits(EventOwner, Player, Results);
+}
+
+void UGameActionStateEvent_HitQuery::DispatchHits(UObject* EventOwner, IMovieScenePlayer& Player, const TArray<FHitResult>& Results)
+{
+	// 同一Actor的多个组件只取第一个命中
+	TArray<FHitResult, TInlineAllocator<8>> Hits;
+	for (const FHitResult& Result : Results)
+	{
+		AActor* HitActor = Result.GetActor();
+		if (HitActor && HitActors.Contains(HitActor) == false)
+		{
+			HitActors.Add(HitActor);
+			Hits.Add(Result);
+		}
+	}
+	for (const FHitResult& Hit : Hits)
+	{
+		WhenHit(EventOwner, Hit, Player);
+	}
+}
+
+void UGameActionStateEvent_HitQuery::SubmitQuery(UObject* EventOwner)
+{
+	UGameActionHitQuerySubsystem* HitQuerySubsystem = UGameActionHitQuerySubsystem::Get(EventOwner);
+	FVector Location;
+	FQuat Rotation;
+	const AActor* IgnoreActor;
+	if (HitQuerySubsystem == nullptr || GetQueryTransform(EventOwner, Location, Rotation, IgnoreActor) == false)
+	{
+		return;
+	}
+
+	const FCollisionShape CollisionShape = MakeCollisionShape();
+	bPendingIsOverlap = bSweep == false || bHasPreviousLocation == false;
+	if (bPendingIsOverlap)
+	{
+		PendingHandle = HitQuerySubsystem->SubmitOverlap(Location, Rotation, TraceChannel, CollisionShape, IgnoreActor);
+	}
+	else
+	{
+		PendingHandle = HitQuerySubsystem->SubmitSweep(PreviousLocation, Location, Rotation, TraceChannel, CollisionShape, IgnoreActor);
+	}
+	PendingFrame = GFrameCounter;
+	PendingRotation = Rotation;
+	PendingStartLocation = PreviousLocation;
+	PreviousLocation = Location;
+	bHasPreviousLocation = true;
+}
+
+bool UGameActionStateEvent_HitQuery::GetQueryTransform(UObject* EventOwner, FVector& OutLocation, FQuat& OutRotation, const AActor*& OutIgnoreActor) const
+{
+	USceneComponent* QueryComponent = GameActionNativeEvents::GetAttachComponent(EventOwner);
+	if (QueryComponent == nullptr)
+	{
+		return false;
+	}
+	const FTransform QueryTransform = FTransform(LocationOffset) * QueryComponent->GetSocketTransform(SocketName);
+	OutLocation = QueryTransform.GetLocation();
+	OutRotation = QueryTransform.GetRotation();
+	OutIgnoreActor = QueryComponent->GetOwner();
+	return true;
+}
+
+FCollisionShape UGameActionStateEvent_HitQuery::MakeCollisionShape() const
+{
+	switch (Shape)
+	{
+	case EGameActionHitQueryShape::Capsule:
+		return FCollisionShape::MakeCapsule(Radius, HalfHeight);
+	case EGameActionHitQueryShape::Box:
+		return FCollisionShape::MakeBox(BoxExtent);
+	default:
+		return FCollisionShape::MakeSphere(Radius);
+	}
+}
@@ -9,8 +9,12 @@
 #include <Engine/ActorChannel.h>
 #include <Engine/Engine.h>
 #include <Engine/NetDriver.h>
+#include <GameFramework/GameStateBase.h>
+#include <GameFramework/PlayerController.h>
+#include <GameFramework/PlayerState.h>
 
 #include "GameAction/GameActionComponent.h"
+#include "GameAction/GameActionReplay.h"
 #include "GameAction/GameActionSegment.h"
 #include "Sequence/GameActionSequencePlayer.h"
 #include "Utils/GameAction_Log.h"
@@ -20,6 +24,7 @@ const FName UGameActionInstanceBase::GameActionOwnerName = TEXT("GameActionOwner
 UGameActionInstanceBase::UGameActionInstanceBase(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 	, bSharePlayer(true)
+	, bShareSequenceData(false)
 {
 #if WITH_EDITORONLY_DATA
 	bIsSimulation = false;
@@ -58,6 +63,7 @@ void UGameActionInstanceBase::GetLifetimeReplicatedProps(TArray<class FLifetimeP
 
 	DOREPLIFETIME(UGameActionInstanceBase, OwningComponent);
 	DOREPLIFETIME_CONDITION(UGameActionInstanceBase, ActivedSegment, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(UGameActionInstanceBase, ActivedServerWorldTime, COND_SkipOwner);
 }
 
 int32 UGameActionInstanceBase::GetFunctionCallspace(UFunction* Function, FFrame* Stack)
@@ -127,6 +133,11 @@ void UGameActionInstanceBase::Tick(float DeltaSeconds)
 		SequencePlayer->Update(DeltaSeconds);
 	}
 
+	if (BufferedEvents.Num() > 0)
+	{
+		RetryBufferedEvents();
+	}
+
 	if (ActivedSegment)
 	{
 		ActivedSegment->TickAction(DeltaSeconds);
@@ -210,16 +221,73 @@ void UGameActionInstanceBase::AbortGameAction()
 
 bool UGameActionInstanceBase::TryEventTransition(FName EventName)
 {
-	if (ActivedSegment)
+	return TryEventTransitionWithBuffer(EventName, 0.f);
+}
+
+bool UGameActionInstanceBase::TryEventTransitionWithBuffer(FName EventName, float BufferDuration)
+{
+	if (BufferDuration < 0.f)
 	{
-		return ActivedSegment->InvokeEventTransition(EventName);
+		BufferDuration = EventBufferDuration;
+	}
+	if (ActivedSegment && ActivedSegment->InvokeEventTransition(EventName))
+	{
+		BufferedEvents.RemoveAll([&](const FBufferedEvent& E) { return E.EventName == EventName; });
+		return true;
+	}
+	if (ActivedSegment && BufferDuration > 0.f)
+	{
+		BufferEvent(EventName, BufferDuration);
 	}
 	return false;
 }
 
+void UGameActionInstanceBase::BufferEvent(const FName& EventName, float BufferDuration)
+{
+	// 同名事件只保留最新的一次输入
+	BufferedEvents.RemoveAll([&](const FBufferedEvent& E) { return E.EventName == EventName; });
+	if (BufferedEvents.Num() == MaxBufferedEventNum)
+	{
+		BufferedEvents.RemoveAt(0, 1, false);
+	}
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	BufferedEvents.Add({ EventName, WorldTime, WorldTime + BufferDuration });
+}
+
+void UGameActionInstanceBase::RetryBufferedEvents()
+{
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	BufferedEvents.RemoveAll([&](const FBufferedEvent& E) { return E.ExpireTime < WorldTime; });
+
+	// 按输入的先后重试，每次求值最多消耗一个事件，剩余的事件留给跳转后的片段
+	for (int32 Idx = 0; Idx < BufferedEvents.Num(); ++Idx)
+	{
+		if (ActivedSegment == nullptr || CanTransition() == false)
+		{
+			return;
+		}
+		const FBufferedEvent BufferedEvent = BufferedEvents[Idx];
+		if (ActivedSegment->InvokeEventTransition(BufferedEvent.EventName))
+		{
+			GameAction_Log(Display, "[%s] 缓存的事件 [%s] 在 %.3f 秒后跳转成功", *GetName(), *BufferedEvent.EventName.ToString(), WorldTime - BufferedEvent.Timestamp);
+			// 跳转时可能重入缓存或清空事件，下标已不可靠，按事件名移除
+			BufferedEvents.RemoveAll([&](const FBufferedEvent& E) { return E.EventName == BufferedEvent.EventName; });
+			return;
+		}
+	}
+}
+
 void UGameActionInstanceBase::ConstructInstance()
 {
 	GameAction_Log(Display, "创建[%s]行为", *GetName());
+	// 预先加载默认入口可能激活的片段资源
+	for (const FGameActionEntryTransition& EntryTransition : DefaultEntry.Transitions)
+	{
+		if (EntryTransition.TransitionToSegment)
+		{
+			EntryTransition.TransitionToSegment->PrefetchResources();
+		}
+	}
 	WhenConstruct();
 }
 
@@ -241,6 +309,11 @@ void UGameActionInstanceBase::DeactiveInstance()
 		}
 	}
 	InstanceManagedSpawnables.Empty();
+	BufferedEvents.Reset();
+	if (OwningComponent)
+	{
+		OwningComponent->RecordReplay(EGameActionReplayRecordType::Deactived, this, nullptr);
+	}
 	WhenInstanceDeactived();
 	OnInstanceDeactivedNative.Broadcast(this, false);
 }
@@ -257,6 +330,11 @@ void UGameActionInstanceBase::AbortInstance()
 		}
 	}
 	InstanceManagedSpawnables.Empty();
+	BufferedEvents.Reset();
+	if (OwningComponent)
+	{
+		OwningComponent->RecordReplay(EGameActionReplayRecordType::Aborted, this, nullptr);
+	}
 	WhenInstanceAborted();
 	OnInstanceDeactivedNative.Broadcast(this, true);
 }
@@ -298,7 +376,15 @@ void UGameActionInstanceBase::OnRep_ActivedSegment(UGameActionSegmentBase* PreAc
 	else if (CurrentActivedSegment)
 	{
 		ActiveInstance();
-		CurrentActivedSegment->ActiveAction();
+		// 主控端不同步激活时间，只有模拟端追赶
+		if (ActivedServerWorldTime > 0.f && IsOwnerNetInitializing())
+		{
+			ActiveSegmentWithCatchUp(CurrentActivedSegment, GetServerWorldTimeSeconds() - ActivedServerWorldTime - GetEstimatedOneWayLatency());
+		}
+		else
+		{
+			CurrentActivedSegment->ActiveAction();
+		}
 	}
 	else if (PreActivedSegment)
 	{
@@ -307,6 +393,43 @@ void UGameActionInstanceBase::OnRep_ActivedSegment(UGameActionSegmentBase* PreAc
 	}
 }
 
+void UGameActionInstanceBase::ActiveSegmentWithCatchUp(UGameActionSegmentBase* Segment, float ElapsedSeconds)
+{
+	// 晚加入、重新进入相关范围或录像拖动进度时片段已播放了一段时间，从该进度开始播放，不重放已发生的帧事件与生成
+	PendingCatchUpSeconds = ElapsedSeconds > CatchUpActivationThreshold ? ElapsedSeconds : 0.f;
+	Segment->ActiveAction();
+	PendingCatchUpSeconds = 0.f;
+}
+
+float UGameActionInstanceBase::ConsumeCatchUpSeconds()
+{
+	const float CatchUpSeconds = PendingCatchUpSeconds;
+	PendingCatchUpSeconds = 0.f;
+	return CatchUpSeconds;
+}
+
+float UGameActionInstanceBase::GetServerWorldTimeSeconds() const
+{
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+float UGameActionInstanceBase::GetEstimatedOneWayLatency() const
+{
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APlayerState* PlayerState = PlayerController ? PlayerController->PlayerState : nullptr;
+	return PlayerState ? PlayerState->ExactPing * 0.5f / 1000.f : 0.f;
+}
+
+bool UGameActionInstanceBase::IsOwnerNetInitializing() const
+{
+	// 同步新建的Actor在初始数据包的属性回调全部执行后才BeginPlay，只有晚加入或进入相关范围时才会新建
+	// 已在相关范围内的Actor新增实例并激活时Actor早已BeginPlay，按正常激活从头播放
+	const ACharacter* OwningCharacter = GetOwner();
+	return OwningCharacter && OwningCharacter->HasActorBegunPlay() == false;
+}
+
 void UGameActionInstanceBase::SyncSequenceOrigin()
 {
 	ActionTransformOrigin = GetOriginTransform();
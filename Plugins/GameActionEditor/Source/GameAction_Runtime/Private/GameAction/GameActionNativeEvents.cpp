@@ -0,0 +1,410 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameAction/GameActionNativeEvents.h"
+#include <Kismet/GameplayStatics.h>
+#include <Sound/SoundBase.h>
+#include <NiagaraFunctionLibrary.h>
+#include <NiagaraSystem.h>
+#include <GameFramework/DamageType.h>
+#include <GameFramework/Pawn.h>
+#include <GameFramework/PlayerController.h>
+#include <Camera/CameraShakeBase.h>
+#include <Camera/PlayerCameraManager.h>
+#include <Engine/World.h>
+#include <Components/SkeletalMeshComponent.h>
+
+#include "GameAction/GameActionComponent.h"
+#include "GameAction/GameActionNativeEventsUtils.h"
+
+namespace GameActionNativeEvents
+{
+	USceneComponent* GetAttachComponent(UObject* EventOwner)
+	{
+		if (USceneComponent* SceneComponent = Cast<USceneComponent>(EventOwner))
+		{
+			return SceneComponent;
+		}
+		if (AActor* Actor = Cast<AActor>(EventOwner))
+		{
+			if (USkeletalMeshComponent* SkeletalMeshComponent = Actor->FindComponentByClass<USkeletalMeshComponent>())
+			{
+				return SkeletalMeshComponent;
+			}
+			return Actor->GetRootComponent();
+		}
+		return nullptr;
+	}
+
+	AActor* GetOwnerActor(UObject* EventOwner)
+	{
+		if (AActor* Actor = Cast<AActor>(EventOwner))
+		{
+			return Actor;
+		}
+		if (UActorComponent* Component = Cast<UActorComponent>(EventOwner))
+		{
+			return Component->GetOwner();
+		}
+		return nullptr;
+	}
+
+	struct FSoundRequest
+	{
+		const UGameActionKeyEvent_PlaySound* Event;
+		TWeakObjectPtr<USceneComponent> Component;
+
+		bool operator==(const FSoundRequest& Other) const { return Event == Other.Event && Component == Other.Component; }
+	};
+
+	struct FNiagaraRequest
+	{
+		const UGameActionKeyEvent_SpawnNiagara* Event;
+		TWeakObjectPtr<USceneComponent> Component;
+
+		bool operator==(const FNiagaraRequest& Other) const { return Event == Other.Event && Component == Other.Component; }
+	};
+
+	struct FDamageRequest
+	{
+		const UGameActionKeyEvent_ApplyDamage* Event;
+		TWeakObjectPtr<USceneComponent> Component;
+
+		bool operator==(const FDamageRequest& Other) const { return Event == Other.Event && Component == Other.Component; }
+	};
+
+	struct FCameraShakeRequest
+	{
+		const UGameActionKeyEvent_CameraShake* Event;
+		TWeakObjectPtr<AActor> Owner;
+		float Scale;
+	};
+
+	void Execute(TArrayView<const FSoundRequest> Requests)
+	{
+		for (const FSoundRequest& Request : Requests)
+		{
+			USceneComponent* Component = Request.Component.Get();
+			if (Component == nullptr)
+			{
+				continue;
+			}
+			const UGameActionKeyEvent_PlaySound* Event = Request.Event;
+			if (Event->bAttach)
+			{
+				UGameplayStatics::SpawnSoundAttached(Event->Sound, Component, Event->SocketName, FVector::ZeroVector, EAttachLocation::SnapToTarget, true, Event->VolumeMultiplier, Event->PitchMultiplier);
+			}
+			else
+			{
+				UGameplayStatics::PlaySoundAtLocation(Component, Event->Sound, Component->GetSocketLocation(Event->SocketName), Event->VolumeMultiplier, Event->PitchMultiplier);
+			}
+		}
+	}
+
+	void Execute(TArrayView<const FNiagaraRequest> Requests)
+	{
+		for (const FNiagaraRequest& Request : Requests)
+		{
+			USceneComponent* Component = Request.Component.Get();
+			if (Component == nullptr)
+			{
+				continue;
+			}
+			const UGameActionKeyEvent_SpawnNiagara* Event = Request.Event;
+			if (Event->bAttach)
+			{
+				UNiagaraFunctionLibrary::SpawnSystemAttached(Event->System, Component, Event->SocketName, Event->LocationOffset, Event->RotationOffset, EAttachLocation::KeepRelativeOffset, true);
+			}
+			else
+			{
+				const FTransform SocketTransform = FTransform(Event->RotationOffset, Event->LocationOffset) * Component->GetSocketTransform(Event->SocketName);
+				UNiagaraFunctionLibrary::SpawnSystemAtLocation(Component, Event->System, SocketTransform.GetLocation(), SocketTransform.Rotator());
+			}
+		}
+	}
+
+	void Execute(TArrayView<const FDamageRequest> Requests)
+	{
+		for (const FDamageRequest& Request : Requests)
+		{
+			USceneComponent* Component = Request.Component.Get();
+			if (Component == nullptr)
+			{
+				continue;
+			}
+			const UGameActionKeyEvent_ApplyDamage* Event = Request.Event;
+			AActor* Owner = Component->GetOwner();
+			const APawn* Pawn = Cast<APawn>(Owner);
+			const TArray<AActor*> IgnoreActors{ Owner };
+			UGameplayStatics::ApplyRadialDamage(Component, Event->BaseDamage, Component->GetSocketLocation(Event->SocketName), Event->DamageRadius, Event->DamageType, IgnoreActors, Owner, Pawn ? Pawn->GetController() : nullptr, Event->bDoFullDamage);
+		}
+	}
+
+	// 与引擎范围震动相同的线性衰减，内半径内为1，外半径外为0
+	float CalcRadialShakeScale(const FVector& CameraLocation, const FVector& Epicenter, float InnerRadius, float OuterRadius)
+	{
+		const float Distance = FVector::Dist(CameraLocation, Epicenter);
+		if (Distance <= InnerRadius)
+		{
+			return 1.f;
+		}
+		if (Distance >= OuterRadius)
+		{
+			return 0.f;
+		}
+		return 1.f - (Distance - InnerRadius) / (OuterRadius - InnerRadius);
+	}
+
+	void Execute(TArrayView<const FCameraShakeRequest> Requests)
+	{
+		for (const FCameraShakeRequest& Request : Requests)
+		{
+			AActor* Owner = Request.Owner.Get();
+			if (Owner == nullptr)
+			{
+				continue;
+			}
+			const UGameActionKeyEvent_CameraShake* Event = Request.Event;
+			if (Event->OuterRadius > 0.f)
+			{
+				// 各端都会求值序列，只震动本地玩家的镜头，PlayWorldCameraShake在服务端会遍历到远端玩家的控制器
+				const FVector Epicenter = Owner->GetActorLocation();
+				for (FConstPlayerControllerIterator It = Owner->GetWorld()->GetPlayerControllerIterator(); It; ++It)
+				{
+					APlayerController* PlayerController = It->Get();
+					if (PlayerController == nullptr || PlayerController->IsLocalController() == false || PlayerController->PlayerCameraManager == nullptr)
+					{
+						continue;
+					}
+					APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+					const float ShakeScale = CalcRadialShakeScale(CameraManager->GetCameraLocation(), Epicenter, Event->InnerRadius, Event->OuterRadius);
+					if (ShakeScale > 0.f)
+					{
+						CameraManager->StartCameraShake(Event->CameraShake, ShakeScale);
+					}
+				}
+			}
+			else if (const APawn* Pawn = Cast<APawn>(Owner))
+			{
+				// 各端都会求值序列，只在本地控制端震动，服务端调用会向主控端再发一次震动
+				APlayerController* PlayerController = Cast<APlayerController>(Pawn->GetController());
+				if (PlayerController && PlayerController->IsLocalController())
+				{
+					PlayerController->ClientStartCameraShake(Event->CameraShake, Request.Scale);
+				}
+			}
+		}
+	}
+
+	// 同一事件对同一对象在一次求值中只执行一次
+	template<typename TRequest>
+	void AddUnique(TArray<TRequest>& Requests, const TRequest& Request)
+	{
+		Requests.AddUnique(Request);
+	}
+
+	// 同一所有者的同类本地镜头震动合并为一次，取最大强度
+	// 范围震动不使用强度，只去掉同一事件的重复
+	void AddUnique(TArray<FCameraShakeRequest>& Requests, const FCameraShakeRequest& Request)
+	{
+		const bool bIsWorldShake = Request.Event->OuterRadius > 0.f;
+		FCameraShakeRequest* Existing = Requests.FindByPredicate([&](const FCameraShakeRequest& E)
+		{
+			if (E.Owner != Request.Owner)
+			{
+				return false;
+			}
+			return bIsWorldShake ? E.Event == Request.Event : E.Event->OuterRadius <= 0.f && E.Event->CameraShake == Request.Event->CameraShake;
+		});
+		if (Existing)
+		{
+			Existing->Scale = FMath::Max(Existing->Scale, Request.Scale);
+		}
+		else
+		{
+			Requests.Add(Request);
+		}
+	}
+
+	struct FBatch
+	{
+		int32 ScopeDepth = 0;
+		TArray<FSoundRequest> SoundRequests;
+		TArray<FNiagaraRequest> NiagaraRequests;
+		TArray<FDamageRequest> DamageRequests;
+		TArray<FCameraShakeRequest> CameraShakeRequests;
+
+		TArray<FSoundRequest>& GetRequests(const FSoundRequest*) { return SoundRequests; }
+		TArray<FNiagaraRequest>& GetRequests(const FNiagaraRequest*) { return NiagaraRequests; }
+		TArray<FDamageRequest>& GetRequests(const FDamageRequest*) { return DamageRequests; }
+		TArray<FCameraShakeRequest>& GetRequests(const FCameraShakeRequest*) { return CameraShakeRequests; }
+
+		// 请求类型在编译期决定放入的队列与执行函数
+		template<typename TRequest>
+		void Enqueue(const TRequest& Request)
+		{
+			if (ScopeDepth > 0)
+			{
+				AddUnique(GetRequests(static_cast<const TRequest*>(nullptr)), Request);
+			}
+			else
+			{
+				Execute(MakeArrayView(&Request, 1));
+			}
+		}
+
+		// 执行前先移出队列，执行中再次求值产生的请求进入空队列，由外层循环继续执行
+		template<typename TRequest>
+		static bool Flush(TArray<TRequest>& Requests)
+		{
+			if (Requests.Num() == 0)
+			{
+				return false;
+			}
+			const TArray<TRequest> PendingRequests = MoveTemp(Requests);
+			Requests.Reset();
+			Execute(MakeArrayView(PendingRequests));
+			return true;
+		}
+
+		// 调用时ScopeDepth仍保持大于0，嵌套的求值只入队不会在执行中途刷新
+		void Flush()
+		{
+			bool bFlushed = true;
+			while (bFlushed)
+			{
+				bFlushed = Flush(SoundRequests);
+				bFlushed |= Flush(NiagaraRequests);
+				bFlushed |= Flush(DamageRequests);
+				bFlushed |= Flush(CameraShakeRequests);
+			}
+		}
+	};
+
+	// 事件只在游戏线程触发
+	FBatch& GetBatch()
+	{
+		check(IsInGameThread());
+		static FBatch Batch;
+		return Batch;
+	}
+}
+
+FGameActionNativeEventBatchScope::FGameActionNativeEventBatchScope()
+{
+	GameActionNativeEvents::GetBatch().ScopeDepth += 1;
+}
+
+FGameActionNativeEventBatchScope::~FGameActionNativeEventBatchScope()
+{
+	GameActionNativeEvents::FBatch& Batch = GameActionNativeEvents::GetBatch();
+	if (Batch.ScopeDepth == 1)
+	{
+		Batch.Flush();
+	}
+	Batch.ScopeDepth -= 1;
+}
+
+UGameActionKeyEvent_PlaySound::UGameActionKeyEvent_PlaySound()
+	: bAttach(false)
+{
+	bNativeEvent = true;
+}
+
+FString UGameActionKeyEvent_PlaySound::GetEventName() const
+{
+	return Sound ? FString::Printf(TEXT("音效[%s]"), *Sound->GetName()) : Super::GetEventName();
+}
+
+void UGameActionKeyEvent_PlaySound::WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const
+{
+	using namespace GameActionNativeEvents;
+	if (Sound)
+	{
+		GetBatch().Enqueue(FSoundRequest{ this, GetAttachComponent(EventOwner) });
+	}
+}
+
+UGameActionKeyEvent_SpawnNiagara::UGameActionKeyEvent_SpawnNiagara()
+	: bAttach(true)
+{
+	bNativeEvent = true;
+}
+
+FString UGameActionKeyEvent_SpawnNiagara::GetEventName() const
+{
+	return System ? FString::Printf(TEXT("特效[%s]"), *System->GetName()) : Super::GetEventName();
+}
+
+void UGameActionKeyEvent_SpawnNiagara::WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const
+{
+	using namespace GameActionNativeEvents;
+	if (System)
+	{
+		GetBatch().Enqueue(FNiagaraRequest{ this, GetAttachComponent(EventOwner) });
+	}
+}
+
+UGameActionKeyEvent_ApplyDamage::UGameActionKeyEvent_ApplyDamage()
+	: bDoFullDamage(false)
+{
+	bNativeEvent = true;
+}
+
+void UGameActionKeyEvent_ApplyDamage::WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const
+{
+	using namespace GameActionNativeEvents;
+	// 伤害只由服务器结算
+	const AActor* Owner = GetOwnerActor(EventOwner);
+	if (Owner && Owner->HasAuthority())
+	{
+		GetBatch().Enqueue(FDamageRequest{ this, GetAttachComponent(EventOwner) });
+	}
+}
+
+UGameActionKeyEvent_CameraShake::UGameActionKeyEvent_CameraShake()
+{
+	bNativeEvent = true;
+}
+
+FString UGameActionKeyEvent_CameraShake::GetEventName() const
+{
+	return CameraShake ? FString::Printf(TEXT("镜头震动[%s]"), *CameraShake->GetName()) : Super::GetEventName();
+}
+
+void UGameActionKeyEvent_CameraShake::WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const
+{
+	using namespace GameActionNativeEvents;
+	if (CameraShake)
+	{
+		GetBatch().Enqueue(FCameraShakeRequest{ this, GetOwnerActor(EventOwner), Scale });
+	}
+}
+
+UGameActionStateEvent_AddGameplayTags::UGameActionStateEvent_AddGameplayTags()
+{
+	bNativeEvent = true;
+}
+
+FString UGameActionStateEvent_AddGameplayTags::GetEventName() const
+{
+	return Tags.IsEmpty() ? Super::GetEventName() : FString::Printf(TEXT("标签%s"), *Tags.ToStringSimple());
+}
+
+void UGameActionStateEvent_AddGameplayTags::WhenEventStart(UObject* EventOwner, IMovieScenePlayer& Player)
+{
+	const AActor* Owner = GameActionNativeEvents::GetOwnerActor(EventOwner);
+	if (UGameActionComponent* GameActionComponent = Owner ? Owner->FindComponentByClass<UGameActionComponent>() : nullptr)
+	{
+		GameActionComponent->AddGameActionTags(Tags);
+	}
+}
+
+void UGameActionStateEvent_AddGameplayTags::WhenEventEnd(UObject* EventOwner, IMovieScenePlayer& Player, bool bIsCompleted)
+{
+	const AActor* Owner = GameActionNativeEvents::GetOwnerActor(EventOwner);
+	if (UGameActionComponent* GameActionComponent = Owner ? Owner->FindComponentByClass<UGameActionComponent>() : nullptr)
+	{
+		GameActionComponent->RemoveGameActionTags(Tags);
+	}
+}
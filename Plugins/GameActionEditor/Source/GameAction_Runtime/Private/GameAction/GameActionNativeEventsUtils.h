@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class USceneComponent;
+
+// 原生事件共用的查找，模块内部使用
+namespace GameActionNativeEvents
+{
+	// 事件拥有者为场景组件时直接使用，为Actor时优先使用骨骼网格体组件
+	USceneComponent* GetAttachComponent(UObject* EventOwner);
+	AActor* GetOwnerActor(UObject* EventOwner);
+}
@@ -0,0 +1,490 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameAction/GameActionReplay.h"
+#include <Engine/World.h>
+#include <Engine/DemoNetDriver.h>
+#include <Engine/PackageMapClient.h>
+#include <Serialization/MemoryWriter.h>
+#include <Serialization/MemoryReader.h>
+#include <UObject/UObjectIterator.h>
+
+#include "GameAction/GameActionComponent.h"
+#include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionSegment.h"
+#include "Sequence/GameActionSequencePlayer.h"
+#include "Utils/GameAction_Log.h"
+
+namespace GameActionReplayUtils
+{
+	constexpr uint32 ChunkVersion = 1;
+	// 防止损坏的数据申请过大的数组
+	constexpr uint32 MaxArrayNum = 65536;
+
+	uint32 ToMilliseconds(float Seconds)
+	{
+		return (uint32)FMath::Max(FMath::RoundToInt(Seconds * 1000.f), 0);
+	}
+
+	// INDEX_NONE编码为0
+	void SerializeIndex(FArchive& Ar, int32& Index)
+	{
+		uint32 Packed = (uint32)(Index + 1);
+		Ar.SerializeIntPacked(Packed);
+		Index = (int32)Packed - 1;
+	}
+
+	template<typename T>
+	void SerializeNum(FArchive& Ar, TArray<T>& Array)
+	{
+		uint32 Num = Array.Num();
+		Ar.SerializeIntPacked(Num);
+		if (Ar.IsLoading())
+		{
+			if (Num > MaxArrayNum)
+			{
+				Ar.SetError();
+				return;
+			}
+			Array.SetNum(Num);
+		}
+	}
+
+	UGameActionSegmentBase* FindSegment(UGameActionInstanceBase* Instance, const FString& SegmentName)
+	{
+		return FindObjectFast<UGameActionSegmentBase>(Instance, *SegmentName);
+	}
+}
+
+void FGameActionReplayChunk::Serialize(FArchive& Ar, FNetworkGUID& OwnerGuid)
+{
+	using namespace GameActionReplayUtils;
+
+	uint32 Version = ChunkVersion;
+	Ar.SerializeIntPacked(Version);
+	if (Version != ChunkVersion)
+	{
+		Ar.SetError();
+		return;
+	}
+	Ar << OwnerGuid;
+	Ar << StartTime;
+
+	SerializeNum(Ar, Names);
+	for (FString& Name : Names)
+	{
+		Ar << Name;
+	}
+
+	// 关键帧保存激活至数据块开始的时长
+	SerializeNum(Ar, Keyframe);
+	for (FGameActionReplayState& State : Keyframe)
+	{
+		SerializeIndex(Ar, State.InstanceName);
+		SerializeIndex(Ar, State.SegmentName);
+		uint32 ElapsedMs = ToMilliseconds(StartTime - State.ActivedTime);
+		Ar.SerializeIntPacked(ElapsedMs);
+		State.ActivedTime = StartTime - ElapsedMs / 1000.f;
+	}
+
+	// 记录保存与前一条记录量化后的时间差，避免误差累积
+	SerializeNum(Ar, Records);
+	uint32 PreviousMs = 0;
+	for (FGameActionReplayRecord& Record : Records)
+	{
+		uint8 Type = (uint8)Record.Type;
+		Ar << Type;
+		Record.Type = (EGameActionReplayRecordType)Type;
+
+		const uint32 RecordMs = Ar.IsSaving() ? FMath::Max(ToMilliseconds(Record.Time - StartTime), PreviousMs) : 0;
+		uint32 DeltaMs = RecordMs - PreviousMs;
+		Ar.SerializeIntPacked(DeltaMs);
+		PreviousMs += DeltaMs;
+		Record.Time = StartTime + PreviousMs / 1000.f;
+
+		SerializeIndex(Ar, Record.InstanceName);
+		if (Record.Type == EGameActionReplayRecordType::Actived)
+		{
+			SerializeIndex(Ar, Record.SegmentName);
+		}
+		else
+		{
+			Record.SegmentName = INDEX_NONE;
+		}
+	}
+
+	if (Ar.IsLoading() && Ar.IsError() == false)
+	{
+		const bool bIsValid = Keyframe.ContainsByPredicate([&](const FGameActionReplayState& E) { return Names.IsValidIndex(E.InstanceName) == false || Names.IsValidIndex(E.SegmentName) == false; }) == false
+			&& Records.ContainsByPredicate([&](const FGameActionReplayRecord& E)
+			{
+				return E.Type > EGameActionReplayRecordType::Aborted || Names.IsValidIndex(E.InstanceName) == false || (E.Type == EGameActionReplayRecordType::Actived && Names.IsValidIndex(E.SegmentName) == false);
+			}) == false;
+		if (bIsValid == false)
+		{
+			Ar.SetError();
+		}
+	}
+}
+
+int32 FGameActionReplayChunk::FindOrAddName(const FString& Name)
+{
+	const int32 Index = Names.IndexOfByKey(Name);
+	return Index != INDEX_NONE ? Index : Names.Add(Name);
+}
+
+void FGameActionReplayRecorder::Tick(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver)
+{
+	// 开始录制时已激活的实例也需要写入关键帧
+	if (ChunkIndex == INDEX_NONE && Component->ActionInstances.ContainsByPredicate([](UGameActionInstanceBase* E) { return E->IsActived(); }))
+	{
+		BeginChunk(Component, DemoNetDriver);
+		Flush(DemoNetDriver);
+	}
+	else if (bDirty && DemoNetDriver->GetDemoCurrentTime() - LastFlushTime >= FlushInterval)
+	{
+		Flush(DemoNetDriver);
+	}
+}
+
+void FGameActionReplayRecorder::Record(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver, EGameActionReplayRecordType Type, UGameActionInstanceBase* Instance, UGameActionSegmentBase* Segment)
+{
+	const float Time = DemoNetDriver->GetDemoCurrentTime();
+	if (ChunkIndex == INDEX_NONE || Time - Chunk.StartTime > KeyframeInterval)
+	{
+		// 关闭的数据块不再追加记录，写入后开启新的数据块
+		Flush(DemoNetDriver);
+		BeginChunk(Component, DemoNetDriver);
+	}
+
+	const FString InstanceName = Instance->GetClass()->GetPathName();
+	FGameActionReplayRecord& Record = Chunk.Records.AddDefaulted_GetRef();
+	Record.Type = Type;
+	Record.Time = Time;
+	Record.InstanceName = Chunk.FindOrAddName(InstanceName);
+	Record.SegmentName = INDEX_NONE;
+	if (Type == EGameActionReplayRecordType::Actived)
+	{
+		const FString SegmentName = Segment->GetName();
+		Record.SegmentName = Chunk.FindOrAddName(SegmentName);
+		ActivedStates.Add(InstanceName, FInstanceState{ SegmentName, Time });
+	}
+	else
+	{
+		ActivedStates.Remove(InstanceName);
+	}
+	bDirty = true;
+}
+
+void FGameActionReplayRecorder::BeginChunk(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver)
+{
+	const float Time = DemoNetDriver->GetDemoCurrentTime();
+	if (ChunkIndex == INDEX_NONE)
+	{
+		OwnerGuid = DemoNetDriver->GuidCache->GetOrAssignNetGUID(Component->GetOwner());
+		// 录制开始前已激活的实例按服务器时间推算激活时间，主控端没有同步激活时间时视为刚激活
+		for (UGameActionInstanceBase* Instance : Component->ActionInstances)
+		{
+			if (UGameActionSegmentBase* ActivedSegment = Instance->ActivedSegment)
+			{
+				const float ElapsedSeconds = Instance->ActivedServerWorldTime > 0.f ? FMath::Max(Instance->GetServerWorldTimeSeconds() - Instance->ActivedServerWorldTime, 0.f) : 0.f;
+				ActivedStates.Add(Instance->GetClass()->GetPathName(), FInstanceState{ ActivedSegment->GetName(), Time - ElapsedSeconds });
+			}
+		}
+	}
+
+	ChunkIndex += 1;
+	Chunk = FGameActionReplayChunk();
+	Chunk.StartTime = Time;
+	// 关键帧本身也需要写入
+	bDirty = true;
+	for (const TPair<FString, FInstanceState>& Pair : ActivedStates)
+	{
+		FGameActionReplayState& State = Chunk.Keyframe.AddDefaulted_GetRef();
+		State.InstanceName = Chunk.FindOrAddName(Pair.Key);
+		State.SegmentName = Chunk.FindOrAddName(Pair.Value.SegmentName);
+		State.ActivedTime = Pair.Value.ActivedTime;
+	}
+}
+
+void FGameActionReplayRecorder::Flush(UDemoNetDriver* DemoNetDriver)
+{
+	if (bDirty == false)
+	{
+		return;
+	}
+	bDirty = false;
+	LastFlushTime = DemoNetDriver->GetDemoCurrentTime();
+
+	// 同一数据块的事件原地更新，录制中断时最多丢失一个写入间隔内的记录
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	Chunk.Serialize(Writer, OwnerGuid);
+	const FString EventName = FString::Printf(TEXT("%s_%s_%d"), *UGameActionReplaySubsystem::ReplayEventGroup, *OwnerGuid.ToString(), ChunkIndex);
+	DemoNetDriver->AddOrUpdateEvent(EventName, UGameActionReplaySubsystem::ReplayEventGroup, OwnerGuid.ToString(), Data);
+}
+
+void FGameActionReplayPlayback::Update(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver)
+{
+	if (Chunks == nullptr)
+	{
+		UGameActionReplaySubsystem* ReplaySubsystem = UGameActionReplaySubsystem::Get(Component);
+		const FNetworkGUID OwnerGuid = DemoNetDriver->GuidCache->GetNetGUID(Component->GetOwner());
+		Chunks = ReplaySubsystem && OwnerGuid.IsValid() ? ReplaySubsystem->FindChunks(DemoNetDriver, OwnerGuid) : nullptr;
+		if (Chunks == nullptr)
+		{
+			return;
+		}
+	}
+
+	const float Time = DemoNetDriver->GetDemoCurrentTime();
+	if (LastTime < 0.f || Time < LastTime || Time - LastTime > SeekThreshold)
+	{
+		Seek(Component, Time);
+	}
+	else
+	{
+		// 连续播放时下一个数据块的关键帧与推进得到的状态一致，直接执行其中的记录
+		while (Chunks->IsValidIndex(ChunkIndex))
+		{
+			const FGameActionReplayChunk& Chunk = (*Chunks)[ChunkIndex];
+			if (Chunk.Records.IsValidIndex(RecordIndex))
+			{
+				const FGameActionReplayRecord& Record = Chunk.Records[RecordIndex];
+				if (Record.Time > Time)
+				{
+					break;
+				}
+				RecordIndex += 1;
+				ApplyRecord(Component, Chunk, Record, Time);
+			}
+			else if (Chunks->IsValidIndex(ChunkIndex + 1) && (*Chunks)[ChunkIndex + 1].StartTime <= Time)
+			{
+				ChunkIndex += 1;
+				RecordIndex = 0;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+	LastTime = Time;
+}
+
+void FGameActionReplayPlayback::Seek(UGameActionComponent* Component, float Time)
+{
+	using namespace GameActionReplayUtils;
+
+	GameAction_Log(Verbose, "[%s]行为录像定位至%.2f秒", *Component->GetOwner()->GetName(), Time);
+
+	// 只求值不晚于目标时间的最后一个关键帧及其后的记录
+	struct FTargetState
+	{
+		FString SegmentName;
+		float ActivedTime;
+	};
+	TMap<FString, FTargetState> TargetStates;
+	ChunkIndex = 0;
+	RecordIndex = 0;
+	const int32 KeyframeChunkIndex = Chunks->FindLastByPredicate([&](const FGameActionReplayChunk& E) { return E.StartTime <= Time; });
+	if (KeyframeChunkIndex != INDEX_NONE)
+	{
+		const FGameActionReplayChunk& Chunk = (*Chunks)[KeyframeChunkIndex];
+		for (const FGameActionReplayState& State : Chunk.Keyframe)
+		{
+			TargetStates.Add(Chunk.Names[State.InstanceName], FTargetState{ Chunk.Names[State.SegmentName], State.ActivedTime });
+		}
+		for (; Chunk.Records.IsValidIndex(RecordIndex) && Chunk.Records[RecordIndex].Time <= Time; ++RecordIndex)
+		{
+			const FGameActionReplayRecord& Record = Chunk.Records[RecordIndex];
+			if (Record.Type == EGameActionReplayRecordType::Actived)
+			{
+				TargetStates.Add(Chunk.Names[Record.InstanceName], FTargetState{ Chunk.Names[Record.SegmentName], Record.Time });
+			}
+			else
+			{
+				TargetStates.Remove(Chunk.Names[Record.InstanceName]);
+			}
+		}
+		ChunkIndex = KeyframeChunkIndex;
+	}
+
+	// 当前的状态不保留，目标时间激活的片段从对应的进度开始播放
+	for (UGameActionInstanceBase* Instance : Component->ActionInstances)
+	{
+		if (UGameActionSegmentBase* ActivedSegment = Instance->ActivedSegment)
+		{
+			ActivedSegment->DeactiveAction();
+			Instance->DeactiveInstance();
+		}
+	}
+	for (const TPair<FString, FTargetState>& Pair : TargetStates)
+	{
+		UGameActionInstanceBase* Instance = Component->FindOrAddReplayInstance(Pair.Key);
+		UGameActionSegmentBase* Segment = Instance ? FindSegment(Instance, Pair.Value.SegmentName) : nullptr;
+		if (Segment)
+		{
+			Instance->ActiveInstance();
+			Instance->ActiveSegmentWithCatchUp(Segment, Time - Pair.Value.ActivedTime);
+		}
+	}
+}
+
+void FGameActionReplayPlayback::ApplyRecord(UGameActionComponent* Component, const FGameActionReplayChunk& RecordChunk, const FGameActionReplayRecord& Record, float Time)
+{
+	using namespace GameActionReplayUtils;
+
+	UGameActionInstanceBase* Instance = Component->FindOrAddReplayInstance(RecordChunk.Names[Record.InstanceName]);
+	if (Instance == nullptr)
+	{
+		return;
+	}
+
+	switch (Record.Type)
+	{
+	case EGameActionReplayRecordType::Actived:
+		if (UGameActionSegmentBase* Segment = FindSegment(Instance, RecordChunk.Names[Record.SegmentName]))
+		{
+			if (UGameActionSegmentBase* ActivedSegment = Instance->ActivedSegment)
+			{
+				TGuardValue<bool> SpawnRegisterIsInActionTransitionGuard(FGameActionPlayerContext::bIsInActionTransition, true);
+				ActivedSegment->DeactiveAction();
+				Instance->ActiveSegmentWithCatchUp(Segment, Time - Record.Time);
+			}
+			else
+			{
+				Instance->ActiveInstance();
+				Instance->ActiveSegmentWithCatchUp(Segment, Time - Record.Time);
+			}
+		}
+		break;
+	case EGameActionReplayRecordType::Deactived:
+		if (UGameActionSegmentBase* ActivedSegment = Instance->ActivedSegment)
+		{
+			ActivedSegment->DeactiveAction();
+			Instance->DeactiveInstance();
+		}
+		break;
+	case EGameActionReplayRecordType::Aborted:
+		if (UGameActionSegmentBase* ActivedSegment = Instance->ActivedSegment)
+		{
+			ActivedSegment->AbortAction();
+			Instance->AbortInstance();
+		}
+		break;
+	}
+}
+
+const FString UGameActionReplaySubsystem::ReplayEventGroup = TEXT("GameAction");
+
+UGameActionReplaySubsystem::UGameActionReplaySubsystem()
+	: bRequested(false)
+{
+}
+
+void UGameActionReplaySubsystem::FlushRecording(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	if (World == nullptr)
+	{
+		return;
+	}
+	for (UGameActionComponent* Component : TObjectRange<UGameActionComponent>())
+	{
+		if (Component->GetWorld() == World)
+		{
+			Component->FlushReplay();
+		}
+	}
+}
+
+UGameActionReplaySubsystem* UGameActionReplaySubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGameActionReplaySubsystem>() : nullptr;
+}
+
+const TArray<FGameActionReplayChunk>* UGameActionReplaySubsystem::FindChunks(UDemoNetDriver* DemoNetDriver, const FNetworkGUID& OwnerGuid)
+{
+	if (bRequested == false)
+	{
+		RequestChunks(DemoNetDriver);
+	}
+	if (PendingRequestNum > 0)
+	{
+		return nullptr;
+	}
+	static const TArray<FGameActionReplayChunk> EmptyChunks;
+	const TArray<FGameActionReplayChunk>* Chunks = OwnerChunks.Find(OwnerGuid);
+	return Chunks ? Chunks : &EmptyChunks;
+}
+
+void UGameActionReplaySubsystem::RequestChunks(UDemoNetDriver* DemoNetDriver)
+{
+	bRequested = true;
+	// 枚举本身也计为一个请求，所有数据取回后才开始回放
+	PendingRequestNum = 1;
+
+	const auto FinishRequest = [](UGameActionReplaySubsystem* ReplaySubsystem)
+	{
+		ReplaySubsystem->PendingRequestNum -= 1;
+		if (ReplaySubsystem->PendingRequestNum == 0)
+		{
+			for (TPair<FNetworkGUID, TArray<FGameActionReplayChunk>>& Pair : ReplaySubsystem->OwnerChunks)
+			{
+				Pair.Value.StableSort([](const FGameActionReplayChunk& LHS, const FGameActionReplayChunk& RHS) { return LHS.StartTime < RHS.StartTime; });
+			}
+		}
+	};
+
+	TWeakObjectPtr<UGameActionReplaySubsystem> WeakThis(this);
+	TWeakObjectPtr<UDemoNetDriver> WeakDemoNetDriver(DemoNetDriver);
+	DemoNetDriver->EnumerateEvents(ReplayEventGroup, [WeakThis, WeakDemoNetDriver, FinishRequest](const FEnumerateEventsResult& Result)
+	{
+		UGameActionReplaySubsystem* ReplaySubsystem = WeakThis.Get();
+		if (ReplaySubsystem == nullptr)
+		{
+			return;
+		}
+
+		UDemoNetDriver* DemoNetDriver = WeakDemoNetDriver.Get();
+		if (DemoNetDriver && Result.WasSuccessful())
+		{
+			for (const FReplayEventListItem& Item : Result.ReplayEventList.ReplayEvents)
+			{
+				ReplaySubsystem->PendingRequestNum += 1;
+				DemoNetDriver->RequestEventData(Item.ID, [WeakThis, FinishRequest](const FRequestEventDataResult& DataResult)
+				{
+					if (UGameActionReplaySubsystem* ReplaySubsystem = WeakThis.Get())
+					{
+						if (DataResult.WasSuccessful())
+						{
+							ReplaySubsystem->AddChunkData(DataResult.ReplayEventListItem);
+						}
+						FinishRequest(ReplaySubsystem);
+					}
+				});
+			}
+		}
+		else
+		{
+			GameAction_Log(Warning, "行为录像数据枚举失败，回放中不会播放行为");
+		}
+		FinishRequest(ReplaySubsystem);
+	});
+}
+
+void UGameActionReplaySubsystem::AddChunkData(const TArray<uint8>& Data)
+{
+	FMemoryReader Reader(Data);
+	FNetworkGUID OwnerGuid;
+	FGameActionReplayChunk Chunk;
+	Chunk.Serialize(Reader, OwnerGuid);
+	if (Reader.IsError() || OwnerGuid.IsValid() == false)
+	{
+		GameAction_Log(Warning, "行为录像数据块解析失败");
+		return;
+	}
+	OwnerChunks.FindOrAdd(OwnerGuid).Add(MoveTemp(Chunk));
+}
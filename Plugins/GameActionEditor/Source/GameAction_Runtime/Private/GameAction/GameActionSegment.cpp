@@ -8,12 +8,17 @@
 #include <Engine/Engine.h>
 #include <Engine/NetDriver.h>
 #include <GameFramework/Character.h>
+#include <Engine/AssetManager.h>
+#include <Engine/StreamableManager.h>
+#include <Misc/CoreDelegates.h>
 
 #include "GameAction/GameActionComponent.h"
 #include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionReplay.h"
 #include "Sequence/GameActionSequence.h"
 #include "Sequence/GameActionSequencePlayer.h"
 #include "Utils/GameAction_Log.h"
+#include "Utils/GameActionDebugEvents.h"
 
 #define LOCTEXT_NAMESPACE "GameActionSegment"
 
@@ -39,11 +44,45 @@ void UGameActionSegmentBase::ActiveAction()
 	UGameActionInstanceBase* Instance = GetOwner();
 	check(Instance->ActivedSegment == nullptr);
 	Instance->ActivedSegment = this;
+	if (Instance->GetOwner()->HasAuthority())
+	{
+		Instance->ActivedServerWorldTime = Instance->GetServerWorldTimeSeconds();
+	}
+	if (UGameActionComponent* Component = Instance->GetComponent())
+	{
+		Component->RecordReplay(EGameActionReplayRecordType::Actived, Instance, this);
+	}
+#if WITH_EDITOR
+	FGameActionDebugEventListener::Publish(FGameActionDebugEvent::EType::Actived, this);
+#endif
+	if (IsLocalControlled())
+	{
+		TickTransitionTracker.Activate(this);
+	}
+	PrefetchTransitionResources();
 	WhenActionActived();
 	check(IsActived());
 	OnActionActivedEvent.ExecuteIfBound();
 }
 
+void UGameActionSegmentBase::PrefetchTransitionResources()
+{
+	for (const FGameActionTickTransition& TickTransition : TickTransitions)
+	{
+		if (TickTransition.TransitionToSegment)
+		{
+			TickTransition.TransitionToSegment->PrefetchResources();
+		}
+	}
+	for (const FGameActionEventTransition& EventTransition : EventTransitions)
+	{
+		if (EventTransition.TransitionToSegment)
+		{
+			EventTransition.TransitionToSegment->PrefetchResources();
+		}
+	}
+}
+
 void UGameActionSegmentBase::AbortAction()
 {
 	GameAction_Log(Display, "中断游戏动作 [%s]", *GetName());
@@ -51,6 +90,9 @@ void UGameActionSegmentBase::AbortAction()
 	UGameActionInstanceBase* Instance = GetOwner();
 	check(Instance->ActivedSegment == this);
 	Instance->ActivedSegment = nullptr;
+#if WITH_EDITOR
+	FGameActionDebugEventListener::Publish(FGameActionDebugEvent::EType::Aborted, this);
+#endif
 	WhenActionAborted();
 	check(IsActived() == false);
 	OnActionAbortedEvent.ExecuteIfBound();
@@ -62,6 +104,9 @@ void UGameActionSegmentBase::DeactiveAction()
 	
 	check(GetOwner()->ActivedSegment == this);
 	GetOwner()->ActivedSegment = nullptr;
+#if WITH_EDITOR
+	FGameActionDebugEventListener::Publish(FGameActionDebugEvent::EType::Deactived, this);
+#endif
 	WhenActionDeactived();
 	check(IsActived() == false);
 	OnActionDeactivedEvent.ExecuteIfBound();
@@ -110,8 +155,19 @@ void UGameActionSegmentBase::TickAction(float DeltaSeconds)
 		{
 			return;
 		}
-		for (const FGameActionTickTransition& TickTransition : TickTransitions)
+		const uint64 DirtyMask = TickTransitionTracker.GatherDirtyMask(this);
+		for (int32 TransitionIndex = 0; TransitionIndex < TickTransitions.Num(); ++TransitionIndex)
 		{
+			// 上次求值为假且依赖未变化的条件不需要再次求值
+			if (TransitionIndex < FGameActionTickTransitionTracker::MaxTrackedNum)
+			{
+				if ((DirtyMask & (uint64(1) << TransitionIndex)) == 0)
+				{
+					continue;
+				}
+				TickTransitionTracker.ClearDirty(TransitionIndex);
+			}
+			const FGameActionTickTransition& TickTransition = TickTransitions[TransitionIndex];
 			if (TickTransition.CanTransition(this, false))
 			{
 				TGuardValue<bool> SpawnRegisterIsInActionTransitionGuard(FGameActionPlayerContext::bIsInActionTransition, true);
@@ -145,6 +201,151 @@ void UGameActionSegmentBase::TickAction(float DeltaSeconds)
 	}
 }
 
+void FGameActionTickTransitionTracker::Activate(const UGameActionSegmentBase* Segment)
+{
+	if (bResolved == false)
+	{
+		Resolve(Segment);
+	}
+	const UGameActionInstanceBase* Instance = Segment->GetOwner();
+	for (const FVariable& Variable : Variables)
+	{
+		Variable.Property->CopyCompleteValue(&Snapshot[Variable.Offset], Variable.Property->ContainerPtrToValuePtr<void>(Instance));
+	}
+	InRangeMask = GetInRangeMask(Segment);
+	OwnerTagsSerial = UGameActionComponent::GetGameActionTagsSerial();
+	DirtyMask = MAX_uint64;
+}
+
+uint64 FGameActionTickTransitionTracker::GatherDirtyMask(const UGameActionSegmentBase* Segment)
+{
+	if (bResolved == false)
+	{
+		Activate(Segment);
+		return DirtyMask;
+	}
+
+	uint64 ChangedVariableMask = 0;
+	const UGameActionInstanceBase* Instance = Segment->GetOwner();
+	for (int32 Idx = 0; Idx < Variables.Num(); ++Idx)
+	{
+		const FVariable& Variable = Variables[Idx];
+		const void* Value = Variable.Property->ContainerPtrToValuePtr<void>(Instance);
+		void* SnapshotValue = &Snapshot[Variable.Offset];
+		if (Variable.Property->Identical(Value, SnapshotValue) == false)
+		{
+			Variable.Property->CopyCompleteValue(SnapshotValue, Value);
+			ChangedVariableMask |= uint64(1) << Idx;
+		}
+	}
+
+	const uint64 CurrentInRangeMask = GetInRangeMask(Segment);
+	const uint64 CrossedTimeWindowMask = CurrentInRangeMask ^ InRangeMask;
+	InRangeMask = CurrentInRangeMask;
+
+	const uint32 CurrentOwnerTagsSerial = UGameActionComponent::GetGameActionTagsSerial();
+	const bool bOwnerTagsChanged = CurrentOwnerTagsSerial != OwnerTagsSerial;
+	OwnerTagsSerial = CurrentOwnerTagsSerial;
+
+	for (int32 Idx = 0; Idx < Transitions.Num(); ++Idx)
+	{
+		const FTransition& Transition = Transitions[Idx];
+		if (Transition.bAlwaysDirty || (Transition.VariableMask & ChangedVariableMask) || (Transition.TimeWindowMask & CrossedTimeWindowMask) || (Transition.bOwnerTags && bOwnerTagsChanged))
+		{
+			DirtyMask |= uint64(1) << Idx;
+		}
+	}
+	return DirtyMask;
+}
+
+void FGameActionTickTransitionTracker::Resolve(const UGameActionSegmentBase* Segment)
+{
+	bResolved = true;
+	ResetSnapshot();
+	Transitions.Reset();
+	TimeWindows.Reset();
+
+	const UClass* InstanceClass = Segment->GetOwner()->GetClass();
+	const bool bSupportTimeWindow = Segment->IsA<UGameActionSegment>();
+	int32 SnapshotSize = 0;
+	for (const FGameActionTickTransition& TickTransition : Segment->TickTransitions)
+	{
+		if (Transitions.Num() == MaxTrackedNum)
+		{
+			break;
+		}
+		FTransition& Transition = Transitions.AddDefaulted_GetRef();
+		const FGameActionTransitionDependency& Dependency = TickTransition.Dependency;
+		if (Dependency.bUnknown || TickTransition.Condition.IsBound() == false)
+		{
+			Transition.bAlwaysDirty = true;
+			continue;
+		}
+		Transition.bOwnerTags = Dependency.bOwnerTags;
+
+		for (const FName& VariableName : Dependency.InstanceVariables)
+		{
+			int32 VariableIndex = Variables.IndexOfByPredicate([&](const FVariable& E) { return E.Property->GetFName() == VariableName; });
+			if (VariableIndex == INDEX_NONE)
+			{
+				const FProperty* Property = FindFProperty<FProperty>(InstanceClass, VariableName);
+				if (Property == nullptr || Variables.Num() == MaxTrackedNum)
+				{
+					Transition.bAlwaysDirty = true;
+					break;
+				}
+				SnapshotSize = Align(SnapshotSize, Property->GetMinAlignment());
+				VariableIndex = Variables.Add({ Property, SnapshotSize });
+				SnapshotSize += Property->GetSize();
+			}
+			Transition.VariableMask |= uint64(1) << VariableIndex;
+		}
+
+		for (const FGameActionTransitionTimeWindow& TimeWindow : Dependency.TimeWindows)
+		{
+			if (bSupportTimeWindow == false || TimeWindows.Num() == MaxTrackedNum)
+			{
+				Transition.bAlwaysDirty = true;
+				break;
+			}
+			Transition.TimeWindowMask |= uint64(1) << TimeWindows.Add(TimeWindow);
+		}
+	}
+
+	Snapshot.SetNumZeroed(SnapshotSize);
+	for (const FVariable& Variable : Variables)
+	{
+		Variable.Property->InitializeValue(&Snapshot[Variable.Offset]);
+	}
+}
+
+void FGameActionTickTransitionTracker::ResetSnapshot()
+{
+	for (const FVariable& Variable : Variables)
+	{
+		Variable.Property->DestroyValue(&Snapshot[Variable.Offset]);
+	}
+	Variables.Reset();
+	Snapshot.Reset();
+}
+
+uint64 FGameActionTickTransitionTracker::GetInRangeMask(const UGameActionSegmentBase* Segment) const
+{
+	uint64 Mask = 0;
+	if (TimeWindows.Num() > 0)
+	{
+		const UGameActionSegment* SequenceSegment = CastChecked<UGameActionSegment>(Segment);
+		for (int32 Idx = 0; Idx < TimeWindows.Num(); ++Idx)
+		{
+			if (SequenceSegment->IsInSequenceTime(TimeWindows[Idx].Lower, TimeWindows[Idx].Upper))
+			{
+				Mask |= uint64(1) << Idx;
+			}
+		}
+	}
+	return Mask;
+}
+
 void UGameActionSegmentBase::TransitionActionFailed(UGameActionSegmentBase* TransitionFailedSegment)
 {
 	WhenTransitionFailed(TransitionFailedSegment);
@@ -330,8 +531,73 @@ void UGameActionSegmentBase::DefaultTransitionFailedToClient_Implementation()
 
 UGameActionSegment::UGameActionSegment(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
+	, bLazyLoadSequence(false)
+{
+	// 共享序列数据时不创建子对象，属性初始化时会直接引用模板中的序列
+	const UGameActionInstanceBase* OwnerInstance = Cast<UGameActionInstanceBase>(GetOuter());
+	const bool bShareTemplateSequence = OwnerInstance && OwnerInstance->IsTemplate() == false && IsTemplate() == false && OwnerInstance->bShareSequenceData;
+	// 延迟加载的模板中序列已移至单独的资源包，实例也不需要创建
+	const UGameActionSegment* Archetype = Cast<UGameActionSegment>(ObjectInitializer.GetArchetype());
+	const bool bArchetypeLazyLoad = Archetype && Archetype->HasAnyFlags(RF_ClassDefaultObject) == false && Archetype->bLazyLoadSequence;
+	if (bShareTemplateSequence == false && bArchetypeLazyLoad == false)
+	{
+		GameActionSequence = CreateDefaultSubobject<UGameActionSequence>(GET_MEMBER_NAME_CHECKED(UGameActionSegment, GameActionSequence));
+	}
+}
+
+UGameActionSequence* UGameActionSegment::GetGameActionSequence() const
 {
-	GameActionSequence = CreateDefaultSubobject<UGameActionSequence>(GET_MEMBER_NAME_CHECKED(UGameActionSegment, GameActionSequence));
+	if (bLazyLoadSequence == false)
+	{
+		return GameActionSequence;
+	}
+	if (UGameActionSequence* LoadedSequence = LazyGameActionSequence.Get())
+	{
+		return LoadedSequence;
+	}
+	GameAction_Log(Warning, "[%s]的延迟加载序列未预先加载完成，同步加载%s", *GetName(), *LazyGameActionSequence.ToString());
+	return LazyGameActionSequence.LoadSynchronous();
+}
+
+void UGameActionSegment::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (bLazyLoadSequence && IsTemplate() == false)
+	{
+		MemoryTrimHandle = FCoreDelegates::GetMemoryTrimDelegate().AddUObject(this, &UGameActionSegment::WhenMemoryTrim);
+	}
+}
+
+void UGameActionSegment::BeginDestroy()
+{
+	if (MemoryTrimHandle.IsValid())
+	{
+		FCoreDelegates::GetMemoryTrimDelegate().Remove(MemoryTrimHandle);
+		MemoryTrimHandle.Reset();
+	}
+	LazySequenceHandle.Reset();
+
+	Super::BeginDestroy();
+}
+
+void UGameActionSegment::PrefetchResources()
+{
+	if (bLazyLoadSequence == false || LazySequenceHandle.IsValid() || LazyGameActionSequence.IsNull())
+	{
+		return;
+	}
+	LazySequenceHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(LazyGameActionSequence.ToSoftObjectPath());
+}
+
+void UGameActionSegment::WhenMemoryTrim()
+{
+	// 激活中的片段保留序列，其余释放引用交由GC卸载
+	if (IsActived() == false && LazySequenceHandle.IsValid())
+	{
+		LazySequenceHandle->ReleaseHandle();
+		LazySequenceHandle.Reset();
+	}
 }
 
 void UGameActionSegment::WhenActionActived()
@@ -339,9 +605,18 @@ void UGameActionSegment::WhenActionActived()
 	UGameActionInstanceBase* Owner = GetOwner();
 	UGameActionSequencePlayer* SequencePlayer = Owner->SequencePlayer;
 	
-	SequencePlayer->Initialize(GetOwner(), GameActionSequence, PlayRate, PlayEndAction);
+	SequencePlayer->Initialize(GetOwner(), GetGameActionSequence(), PlayRate, PlayEndAction);
 	Owner->SyncSequenceOrigin();
-	SequencePlayer->Play();
+	const float CatchUpSeconds = Owner->ConsumeCatchUpSeconds();
+	// 倒放的片段仍然从头播放，由网络同步修正
+	if (CatchUpSeconds > 0.f && PlayRate > 0.f)
+	{
+		SequencePlayer->PlayFromSeconds(CatchUpSeconds * PlayRate);
+	}
+	else
+	{
+		SequencePlayer->Play();
+	}
 
 	if (IsLocalControlled())
 	{
@@ -435,7 +710,7 @@ float UGameActionSegment::GetCurrentPlayTime() const
 
 float UGameActionSegment::GetSequenceTotalTime() const
 {
-	UMovieScene* MovieScene = GameActionSequence->GetMovieScene();
+	UMovieScene* MovieScene = GetGameActionSequence()->GetMovieScene();
 	return MovieScene->GetTickResolution().AsSeconds(MovieScene->GetPlaybackRange().Size<FFrameNumber>());
 }
 
@@ -5,6 +5,7 @@
 #include <Compilation/MovieSceneCompilerRules.h>
 #include <Channels/MovieSceneChannelProxy.h>
 #include <Animation/AnimInstance.h>
+#include <MovieScene.h>
 
 #include "GameAction/GameActionInstance.h"
 #include "Sequence/GameActionSequencePlayer.h"
@@ -15,7 +16,7 @@ namespace GameAction
 {
 	struct FMinimalAnimParameters
 	{
-		FMinimalAnimParameters(UAnimMontage* Montage, float InFromEvalTime, float InToEvalTime, float InBlendWeight, FFrameTime FrameTime, const FMovieSceneByteChannel& TearDownStrategyChannel, const FMovieSceneEvaluationScope& InScope, FObjectKey InSection)
+		FMinimalAnimParameters(UAnimMontage* Montage, float InFromEvalTime, float InToEvalTime, float InBlendWeight, FFrameTime FrameTime, const FMovieSceneByteChannel& TearDownStrategyChannel, const FMovieSceneEvaluationScope& InScope, FObjectKey InSection, int32 InSectionIndex)
 			: Montage(Montage)
 			, FromEvalTime(InFromEvalTime)
 			, ToEvalTime(InToEvalTime)
@@ -24,6 +25,7 @@ namespace GameAction
 			, TearDownStrategyChannel(TearDownStrategyChannel)
 			, EvaluationScope(InScope)
 			, Section(InSection)
+			, SectionIndex(InSectionIndex)
 		{}
 
 		UAnimMontage* Montage;
@@ -34,6 +36,7 @@ namespace GameAction
 		const FMovieSceneByteChannel& TearDownStrategyChannel;
 		FMovieSceneEvaluationScope EvaluationScope;
 		FObjectKey Section;
+		int32 SectionIndex;
 	};
 	struct FSimulatedAnimParameters
 	{
@@ -43,15 +46,28 @@ namespace GameAction
 	/** Montage player per section data */
 	struct FMontagePlayerPerSectionData
 	{
+		// 编号冲突时用于校验是否为同一个Section
+		FObjectKey Section;
 		TWeakObjectPtr<UAnimMontage> Montage = nullptr;
 		int32 MontageInstanceId = INDEX_NONE;
 		FAlphaBlend BlendIn;
 	};
 
+	/** 每个动画实例的蒙太奇实例缓存，按编译时的Section编号索引 */
+	struct FMontagePlayerPerAnimInstanceData
+	{
+		TWeakObjectPtr<UAnimInstance> AnimInstance;
+		TArray<FMontagePlayerPerSectionData> Sections;
+	};
+
+	// 通常同时只有1~3个Section重叠，超出时才在堆上分配
+	// 编辑器中的Sequencer预览不经过播放器求值，不能使用帧栈分配
+	using FAnimParametersArray = TArray<FMinimalAnimParameters, TInlineAllocator<3>>;
+
 	struct FBlendedAnimation
 	{
-		TArray<FMinimalAnimParameters> SimulatedAnimations;
-		TArray<FMinimalAnimParameters> AllAnimations;
+		FAnimParametersArray SimulatedAnimations;
+		FAnimParametersArray AllAnimations;
 
 		FBlendedAnimation& Resolve(TMovieSceneInitialValueStore<FBlendedAnimation>& InitialValueStore)
 		{
@@ -115,14 +131,16 @@ namespace GameAction
 
 			if (SequencerInstance)
 			{
-				for (const TPair<FObjectKey, FMontagePlayerPerSectionData >& Pair : MontageData)
+				if (FMontagePlayerPerAnimInstanceData* AnimInstanceData = FindAnimInstanceData(SequencerInstance))
 				{
-					const int32 InstanceId = Pair.Value.MontageInstanceId;
-					FAnimMontageInstance* MontageInstanceToUpdate = SequencerInstance->GetMontageInstanceForID(InstanceId);
-					if (MontageInstanceToUpdate)
+					for (const FMontagePlayerPerSectionData& SectionData : AnimInstanceData->Sections)
 					{
-						MontageInstanceToUpdate->SetDesiredWeight(0.0f);
-						MontageInstanceToUpdate->SetWeight(0.0f);
+						FAnimMontageInstance* MontageInstanceToUpdate = SequencerInstance->GetMontageInstanceForID(SectionData.MontageInstanceId);
+						if (MontageInstanceToUpdate)
+						{
+							MontageInstanceToUpdate->SetDesiredWeight(0.0f);
+							MontageInstanceToUpdate->SetWeight(0.0f);
+						}
 					}
 				}
 			}
@@ -274,18 +292,45 @@ namespace GameAction
 			const float Weight = AnimParams.BlendWeight;
 			if (UAnimInstance* AnimInst = SkeletalMeshComponent->GetAnimInstance())
 			{
-				FMontagePlayerPerSectionData& DataContainer = MontageData.FindOrAdd(Section);
+				FMontagePlayerPerAnimInstanceData& AnimInstanceData = FindOrAddAnimInstanceData(AnimInst);
+				const int32 SectionIndex = FMath::Max(AnimParams.SectionIndex, 0);
+				if (AnimInstanceData.Sections.Num() <= SectionIndex)
+				{
+					AnimInstanceData.Sections.SetNum(SectionIndex + 1);
+				}
+				FMontagePlayerPerSectionData& DataContainer = AnimInstanceData.Sections[SectionIndex];
+				if (DataContainer.Section != Section)
+				{
+					DataContainer = FMontagePlayerPerSectionData();
+					DataContainer.Section = Section;
+				}
 
 				FAnimMontageInstance* MontageInstanceToUpdate = AnimInst->GetMontageInstanceForID(DataContainer.MontageInstanceId);
-				// 正在BlendOut的实例不能复用
-				if (MontageInstanceToUpdate == nullptr || MontageInstanceToUpdate->bEnableAutoBlendOut == true)
+				if (MontageInstanceToUpdate == nullptr || MontageInstanceToUpdate->Montage != InAnimMontage)
 				{
-					AnimInst->Montage_Play(InAnimMontage, 1.f, EMontagePlayReturnType::MontageLength, InFromPosition, true);
-					MontageInstanceToUpdate = AnimInst->GetActiveInstanceForMontage(InAnimMontage);
+					// 前一个片段使用同一蒙太奇且正在混出时，新实例从其当前权重混入
+					// 不直接复活已停止的实例：停止时实例已从ActiveMontagesMap与根运动实例中移除，只有Montage_Play会重新登记并广播OnMontageStarted
+					const FAnimMontageInstance* BlendingOutInstance = FindBlendingOutInstance(AnimInst, InAnimMontage);
+					const int32 BlendingOutInstanceId = BlendingOutInstance ? BlendingOutInstance->GetInstanceID() : INDEX_NONE;
+					const float BlendingOutWeight = BlendingOutInstance ? BlendingOutInstance->GetWeight() : 0.f;
+
+					if (AnimInst->Montage_Play(InAnimMontage, 1.f, EMontagePlayReturnType::MontageLength, InFromPosition, true) <= 0.f)
+					{
+						return;
+					}
+					// Montage_Play会将新实例添加至末尾
+					MontageInstanceToUpdate = AnimInst->MontageInstances.Last();
 					MontageInstanceToUpdate->bEnableAutoBlendOut = false;
 					DataContainer.BlendIn = InAnimMontage->BlendIn;
 					DataContainer.Montage = InAnimMontage;
 					DataContainer.MontageInstanceId = MontageInstanceToUpdate->GetInstanceID();
+
+					if (FAnimMontageInstance* PreMontageInstance = BlendingOutInstanceId != INDEX_NONE ? AnimInst->GetMontageInstanceForID(BlendingOutInstanceId) : nullptr)
+					{
+						// 权重交接给新实例，旧实例立即结束，避免两者叠加
+						DataContainer.BlendIn.SetValueRange(BlendingOutWeight, 1.f);
+						PreMontageInstance->Stop(FAlphaBlend(0.f), false);
+					}
 				}
 				check(MontageInstanceToUpdate);
 				
@@ -298,7 +343,7 @@ namespace GameAction
 						DataContainer.BlendIn.Update(DeltaTime);
 					}
 					MontageInstanceToUpdate->SetDesiredWeight(Weight* DataContainer.BlendIn.GetDesiredValue());
-					MontageInstanceToUpdate->SetWeight(Weight* DataContainer.BlendIn.GetAlpha());
+					MontageInstanceToUpdate->SetWeight(Weight* DataContainer.BlendIn.GetBlendedValue());
 				}
 				else
 				{
@@ -391,8 +436,39 @@ namespace GameAction
 			}
 		}
 
+		FMontagePlayerPerAnimInstanceData* FindAnimInstanceData(const UAnimInstance* AnimInstance)
+		{
+			return MontageData.FindByPredicate([&](const FMontagePlayerPerAnimInstanceData& E) { return E.AnimInstance == AnimInstance; });
+		}
+
+		FMontagePlayerPerAnimInstanceData& FindOrAddAnimInstanceData(UAnimInstance* AnimInstance)
+		{
+			if (FMontagePlayerPerAnimInstanceData* AnimInstanceData = FindAnimInstanceData(AnimInstance))
+			{
+				return *AnimInstanceData;
+			}
+			// 顺便清理已销毁的动画实例
+			MontageData.RemoveAllSwap([](const FMontagePlayerPerAnimInstanceData& E) { return E.AnimInstance.IsValid() == false; });
+			FMontagePlayerPerAnimInstanceData& AnimInstanceData = MontageData.AddDefaulted_GetRef();
+			AnimInstanceData.AnimInstance = AnimInstance;
+			return AnimInstanceData;
+		}
+
+		static FAnimMontageInstance* FindBlendingOutInstance(UAnimInstance* AnimInstance, const UAnimMontage* Montage)
+		{
+			for (FAnimMontageInstance* MontageInstance : AnimInstance->MontageInstances)
+			{
+				if (MontageInstance && MontageInstance->Montage == Montage && MontageInstance->bEnableAutoBlendOut && MontageInstance->IsStopped())
+				{
+					return MontageInstance;
+				}
+			}
+			return nullptr;
+		}
+
 		TMovieSceneAnimTypeIDContainer<FObjectKey> SectionToAnimationIDs;
-		TMap<FObjectKey, FMontagePlayerPerSectionData> MontageData;
+		// 通常只驱动一两个角色，线性查找即可
+		TArray<FMontagePlayerPerAnimInstanceData, TInlineAllocator<2>> MontageData;
 	};
 
 }
@@ -447,8 +523,9 @@ float FGameActionAnimationSectionTemplateParameters::MapTimeToAnimation(FFrameTi
 	return AnimPosition;
 }
 
-FGameActionAnimationSectionTemplate::FGameActionAnimationSectionTemplate(const UGameActionAnimationSection& InSection)
+FGameActionAnimationSectionTemplate::FGameActionAnimationSectionTemplate(const UGameActionAnimationSection& InSection, int32 InSectionIndex)
 	: Params(InSection.Params, InSection.GetInclusiveStartFrame(), InSection.GetExclusiveEndFrame())
+	, SectionIndex(InSectionIndex)
 {
 }
 
@@ -477,7 +554,7 @@ void FGameActionAnimationSectionTemplate::Evaluate(const FMovieSceneEvaluationOp
 
 		// Add the blendable to the accumulator
 		GameAction::FMinimalAnimParameters AnimParams(
-			Params.Montage, PreviousEvalTime, EvalTime, Weight, Context.GetTime(), Params.TearDownStrategy, ExecutionTokens.GetCurrentScope(), GetSourceSection()
+			Params.Montage, PreviousEvalTime, EvalTime, Weight, Context.GetTime(), Params.TearDownStrategy, ExecutionTokens.GetCurrentScope(), GetSourceSection(), SectionIndex
 		);
 		ExecutionTokens.BlendToken(ActuatorTypeID, TBlendableToken<GameAction::FBlendedAnimation>(AnimParams, BlendType.Get(), 1.f));
 
@@ -681,7 +758,44 @@ FMovieSceneTrackRowSegmentBlenderPtr UGameActionAnimationTrack::GetRowSegmentBle
 
 FMovieSceneEvalTemplatePtr UGameActionAnimationTrack::CreateTemplateForSection(const UMovieSceneSection& InSection) const
 {
-	return FGameActionAnimationSectionTemplate(*CastChecked<UGameActionAnimationSection>(&InSection));
+	return FGameActionAnimationSectionTemplate(*CastChecked<UGameActionAnimationSection>(&InSection), GetCompiledSectionIndex(InSection));
+}
+
+int32 UGameActionAnimationTrack::GetCompiledSectionIndex(const UMovieSceneSection& InSection) const
+{
+	// 同一序列中所有动画轨道的Section统一编号，执行器共享同一份按编号索引的数组
+	int32 SectionOffset = 0;
+	const auto FindInTracks = [&](const TArray<UMovieSceneTrack*>& Tracks)
+	{
+		for (const UMovieSceneTrack* Track : Tracks)
+		{
+			if (Track == this)
+			{
+				return true;
+			}
+			if (const UGameActionAnimationTrack* AnimationTrack = Cast<UGameActionAnimationTrack>(Track))
+			{
+				SectionOffset += AnimationTrack->Sections.Num();
+			}
+		}
+		return false;
+	};
+
+	if (const UMovieScene* MovieScene = GetTypedOuter<UMovieScene>())
+	{
+		for (const FMovieSceneBinding& Binding : MovieScene->GetBindings())
+		{
+			if (FindInTracks(Binding.GetTracks()))
+			{
+				return SectionOffset + Sections.IndexOfByKey(&InSection);
+			}
+		}
+		if (FindInTracks(MovieScene->GetMasterTracks()))
+		{
+			return SectionOffset + Sections.IndexOfByKey(&InSection);
+		}
+	}
+	return Sections.IndexOfByKey(&InSection);
 }
 
 #if WITH_EDITOR
@@ -9,7 +9,9 @@
 #include <MovieSceneExecutionToken.h>
 #include <Evaluation/MovieSceneEvaluationTrack.h>
 
+#include "GameAction/GameActionComponent.h"
 #include "GameAction/GameActionEvent.h"
+#include "GameAction/GameActionInstance.h"
 #include "Sequence/GameActionSequencePlayer.h"
 
 #define LOCTEXT_NAMESPACE "GameActionEventTrack"
@@ -210,7 +212,15 @@ void FGameActionStateEventSectionTemplate::Initialize(const FMovieSceneEvaluatio
 			UGameActionStateEvent* StateEvent = Section->StateEvent;
 			if (Section->StateEvent->bInstanced)
 			{
-				StateEvent = NewObject<UGameActionStateEvent>(Player.GetPlaybackContext(), Section->StateEvent->GetClass(), NAME_None, RF_StrongRefOnFrame, Section->StateEvent);
+				const UGameActionInstanceBase* GameActionInstance = Cast<UGameActionInstanceBase>(Player.GetPlaybackContext());
+				if (UGameActionComponent* Component = GameActionInstance ? GameActionInstance->GetComponent() : nullptr)
+				{
+					StateEvent = Component->AcquireStateEventInstance(Section->StateEvent);
+				}
+				else
+				{
+					StateEvent = NewObject<UGameActionStateEvent>(Player.GetPlaybackContext(), Section->StateEvent->GetClass(), NAME_None, RF_StrongRefOnFrame, Section->StateEvent);
+				}
 				EvaluationData.Instance = StateEvent;
 			}
 			
@@ -333,6 +343,16 @@ void FGameActionStateEventSectionTemplate::TearDown(FPersistentEvaluationData& P
 				StateEvent->EndEvent(Obj, Player, FGameActionPlayerContext::bIsPlayAborted == false);
 			}
 		}
+
+		if (EvaluationData.Instance)
+		{
+			const UGameActionInstanceBase* GameActionInstance = Cast<UGameActionInstanceBase>(Player.GetPlaybackContext());
+			if (UGameActionComponent* Component = GameActionInstance ? GameActionInstance->GetComponent() : nullptr)
+			{
+				Component->ReleaseStateEventInstance(Section->StateEvent, EvaluationData.Instance);
+			}
+			EvaluationData.Instance = nullptr;
+		}
 	}
 }
 
@@ -67,6 +67,7 @@ void UGameActionSequence::BindPossessableObject(const FGuid& ObjectId, UObject&
 			FGameActionSequenceSubobjectBinding GameActionSequenceSubobjectBinding;
 			GameActionSequenceSubobjectBinding.OwnerPropertyName = OwnerName;
 			GameActionSequenceSubobjectBinding.PathToSubobject = PossessedObject.GetPathName(Owner);
+			BuildSubobjectNames(GameActionSequenceSubobjectBinding);
 			BindingSubobjects.Add(ObjectId, GameActionSequenceSubobjectBinding);
 		}
 	}
@@ -76,6 +77,7 @@ void UGameActionSequence::UnbindPossessableObjects(const FGuid& ObjectId)
 {
 	PossessableActors.Remove(ObjectId);
 	BindingSubobjects.Remove(ObjectId);
+	CompiledPossessableProperties.Remove(ObjectId);
 }
 
 bool UGameActionSequence::CanPossessObject(UObject& Object, UObject* InPlaybackContext) const
@@ -111,13 +113,14 @@ void UGameActionSequence::LocateBoundObjects(const FGuid& ObjectId, UObject* Con
 
 	if (UGameActionInstanceBase* GameActionInstance = Cast<UGameActionInstanceBase>(Context))
 	{
+		UClass* InstanceClass = GameActionInstance->GetClass();
 		if (OwnerGuid == ObjectId)
 		{
 			OutObjects.Add(GameActionInstance->GetOwner());
 		}
 		else if (const FName* PropertyName = PossessableActors.Find(ObjectId))
 		{
-			if (FObjectProperty* ObjectProperty = FindFProperty<FObjectProperty>(GameActionInstance->GetClass(), *PropertyName))
+			if (FObjectProperty* ObjectProperty = FindBindingProperty(InstanceClass, CompiledPossessableProperties.Find(ObjectId), *PropertyName))
 			{
 				if (UObject** P_Object = ObjectProperty->ContainerPtrToValuePtr<UObject*>(GameActionInstance))
 				{
@@ -134,7 +137,7 @@ void UGameActionSequence::LocateBoundObjects(const FGuid& ObjectId, UObject* Con
 			}
 			else
 			{
-				if (FObjectProperty* ObjectProperty = FindFProperty<FObjectProperty>(GameActionInstance->GetClass(), SubobjectBinding->OwnerPropertyName))
+				if (FObjectProperty* ObjectProperty = FindBindingProperty(InstanceClass, &SubobjectBinding->OwnerProperty, SubobjectBinding->OwnerPropertyName))
 				{
 					if (AActor** P_Owner = ObjectProperty->ContainerPtrToValuePtr<AActor*>(GameActionInstance))
 					{
@@ -145,7 +148,16 @@ void UGameActionSequence::LocateBoundObjects(const FGuid& ObjectId, UObject* Con
 
 			if (OwnerActor)
 			{
-				OutObjects.Add(FindObject<UObject>(OwnerActor, *SubobjectBinding->PathToSubobject));
+				// 绑定的Actor没有变化时直接使用缓存的子对象
+				UGameActionInstanceBase::FResolvedSubobjectBinding& ResolvedBinding = GameActionInstance->ResolvedSubobjectBindings.FindOrAdd(ObjectId);
+				UObject* Subobject = ResolvedBinding.Subobject.Get();
+				if (Subobject == nullptr || ResolvedBinding.OwnerActor.Get() != OwnerActor)
+				{
+					Subobject = FindSubobject(OwnerActor, *SubobjectBinding);
+					ResolvedBinding.OwnerActor = OwnerActor;
+					ResolvedBinding.Subobject = Subobject;
+				}
+				OutObjects.Add(Subobject);
 			}
 		}
 	}
@@ -153,9 +165,53 @@ void UGameActionSequence::LocateBoundObjects(const FGuid& ObjectId, UObject* Con
 	{
 		if (const FGameActionSequenceSubobjectBinding* SubObjectBinding = BindingSubobjects.Find(ObjectId))
 		{
-			OutObjects.Add(FindObject<UActorComponent>(Actor, *SubObjectBinding->PathToSubobject));
+			OutObjects.Add(Cast<UActorComponent>(FindSubobject(Actor, *SubObjectBinding)));
+		}
+	}
+}
+
+FObjectProperty* UGameActionSequence::FindBindingProperty(UClass* InstanceClass, const TFieldPath<FObjectProperty>* CompiledProperty, const FName& PropertyName) const
+{
+	if (CompiledProperty)
+	{
+		FObjectProperty* ObjectProperty = CompiledProperty->Get();
+		if (ObjectProperty && ObjectProperty->GetFName() == PropertyName && InstanceClass->IsChildOf(ObjectProperty->GetOwnerClass()))
+		{
+			return ObjectProperty;
+		}
+	}
+	// 未经过编译的旧数据退化为按名字查找
+	return FindFProperty<FObjectProperty>(InstanceClass, PropertyName);
+}
+
+UObject* UGameActionSequence::FindSubobject(AActor* OwnerActor, const FGameActionSequenceSubobjectBinding& SubobjectBinding)
+{
+	if (SubobjectBinding.SubobjectNames.Num() == 0)
+	{
+		return FindObject<UObject>(OwnerActor, *SubobjectBinding.PathToSubobject);
+	}
+
+	UObject* Subobject = OwnerActor;
+	for (const FName& SubobjectName : SubobjectBinding.SubobjectNames)
+	{
+		Subobject = StaticFindObjectFast(UObject::StaticClass(), Subobject, SubobjectName);
+		if (Subobject == nullptr)
+		{
+			break;
 		}
 	}
+	return Subobject;
+}
+
+void UGameActionSequence::BuildSubobjectNames(FGameActionSequenceSubobjectBinding& SubobjectBinding)
+{
+	SubobjectBinding.SubobjectNames.Reset();
+	TArray<FString> Names;
+	SubobjectBinding.PathToSubobject.Replace(SUBOBJECT_DELIMITER, TEXT(".")).ParseIntoArray(Names, TEXT("."));
+	for (const FString& Name : Names)
+	{
+		SubobjectBinding.SubobjectNames.Add(*Name);
+	}
 }
 
 UObject* UGameActionSequence::GetParentObject(UObject* Object) const
@@ -182,6 +238,7 @@ void UGameActionSequence::PreSave(const ITargetPlatform* TargetPlatform)
 #if WITH_EDITOR
 	if (TargetPlatform && TargetPlatform->RequiresCookedData())
 	{
+		// 引擎在Super::PreSave中将编译数据随序列一同打包，编辑用的轨道需在此之前移除
 		if (UGameActionTimeTestingTrack* TimeTestingTrack = MovieScene->FindMasterTrack<UGameActionTimeTestingTrack>())
 		{
 			MovieScene->RemoveMasterTrack(*TimeTestingTrack);
@@ -192,6 +249,26 @@ void UGameActionSequence::PreSave(const ITargetPlatform* TargetPlatform)
 }
 
 #if WITH_EDITOR
+void UGameActionSequence::CompileBindings(UClass* InstanceClass)
+{
+	check(InstanceClass);
+	CompiledPossessableProperties.Reset();
+	for (const TPair<FGuid, FName>& Pair : PossessableActors)
+	{
+		if (FObjectProperty* ObjectProperty = FindFProperty<FObjectProperty>(InstanceClass, Pair.Value))
+		{
+			CompiledPossessableProperties.Add(Pair.Key, ObjectProperty);
+		}
+	}
+
+	for (TPair<FGuid, FGameActionSequenceSubobjectBinding>& Pair : BindingSubobjects)
+	{
+		FGameActionSequenceSubobjectBinding& SubobjectBinding = Pair.Value;
+		SubobjectBinding.OwnerProperty = SubobjectBinding.OwnerPropertyName != UGameActionInstanceBase::GameActionOwnerName ? FindFProperty<FObjectProperty>(InstanceClass, SubobjectBinding.OwnerPropertyName) : nullptr;
+		BuildSubobjectNames(SubobjectBinding);
+	}
+}
+
 FGuid UGameActionSequence::SetOwnerCharacter(const TSubclassOf<ACharacter>& OwnerType)
 {
 	const FGuid BindingID = MovieScene->AddPossessable(TEXT("Owner"), OwnerType);
@@ -9,6 +9,21 @@
 
 #include "GameAction/GameActionInstance.h"
 
+AActor** UGameActionSequenceSpawnerSettingsBase::GetReferenceSlot(UGameActionInstanceBase* GameActionInstance, const FName& TemplateName) const
+{
+	FObjectProperty* ObjectProperty = ReferenceProperty.Get();
+	if (ObjectProperty == nullptr || GameActionInstance->GetClass()->IsChildOf(ObjectProperty->GetOwnerClass()) == false)
+	{
+		// 未经过编译的旧数据退化为按名字查找
+		ObjectProperty = FindFProperty<FObjectProperty>(GameActionInstance->GetClass(), TemplateName);
+		if (ObjectProperty == nullptr)
+		{
+			return nullptr;
+		}
+	}
+	return ObjectProperty->ContainerPtrToValuePtr<AActor*>(GameActionInstance);
+}
+
 #if WITH_EDITOR
 AActor* UGameActionSequenceCustomSpawner::GetPreviewInstance(UObject* Outer) const
 {
@@ -17,6 +17,7 @@
 #include <GameFramework/PlayerController.h>
 
 #include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionNativeEvents.h"
 #include "GameAction/GameActionSegment.h"
 #include "Sequence/GameActionDynamicSpawnTrack.h"
 #include "Sequence/GameActionSequence.h"
@@ -57,12 +58,7 @@ UObject* FGameActionSpawnRegister::SpawnObject(FMovieSceneSpawnable& Spawnable,
 	AActor** P_Spawnable = &LocalSpawnableRef;
 	if (FGameActionPlayerContext::CurrentSpawnerSettings->bAsReference)
 	{
-		FObjectProperty* ObjectProperty = FindFProperty<FObjectProperty>(GameActionInstance->GetClass(), ActorTemplate->GetFName());
-		if (ensure(ObjectProperty) == false)
-		{
-			return nullptr;
-		}
-		P_Spawnable = ObjectProperty->ContainerPtrToValuePtr<AActor*>(GameActionInstance);
+		P_Spawnable = FGameActionPlayerContext::CurrentSpawnerSettings->GetReferenceSlot(GameActionInstance, ActorTemplate->GetFName());
 		if (ensure(P_Spawnable) == false)
 		{
 			return nullptr;
@@ -532,6 +528,7 @@ void UGameActionSequencePlayer::Pause()
 
 			FMovieSceneEvaluationRange CurrentTimeRange = PlayPosition.GetCurrentPositionAsRange();
 			const FMovieSceneContext Context(CurrentTimeRange, EMovieScenePlayerStatus::Stopped);
+			FGameActionNativeEventBatchScope NativeEventBatchScope;
 			RootTemplateInstance.Evaluate(Context, *this);
 
 			bIsEvaluating = false;
@@ -555,6 +552,40 @@ void UGameActionSequencePlayer::Pause()
 	}
 }
 
+void UGameActionSequencePlayer::PlayFromSeconds(float TimeInSeconds)
+{
+	if (bIsEvaluating || IsPlaying() || Sequence == nullptr || DurationFrames <= 0)
+	{
+		PlayInternal();
+		return;
+	}
+
+	FFrameTime CatchUpPosition = FFrameTime(StartTime) + TimeInSeconds * PlayPosition.GetInputRate();
+	if (PlayEndAction == EGameActionPlayerEndAction::Loop)
+	{
+		const int32 LoopedFrame = (CatchUpPosition.FrameNumber - StartTime).Value % DurationFrames;
+		CatchUpPosition = FFrameTime(StartTime + LoopedFrame, CatchUpPosition.GetSubFrame());
+	}
+	else
+	{
+		// 停在最后一帧时开始播放会回到开头，留出一帧让播放自然结束
+		CatchUpPosition = FMath::Clamp(CatchUpPosition, FFrameTime(StartTime), FMath::Max(GetLastValidTime() - FFrameTime(1), FFrameTime(StartTime)));
+	}
+
+	if (CatchUpPosition > FFrameTime(StartTime))
+	{
+		if (!RootTemplateInstance.IsValid())
+		{
+			RootTemplateInstance.Initialize(*Sequence, *this, nullptr);
+		}
+		// 先开启捕获，追赶时修改的状态在结束时同样能够还原
+		PreAnimatedState.EnableGlobalCapture();
+		// 跳转以停止状态求值，事件轨道不会执行帧事件，状态事件只启动当前时间处于的状态
+		JumpToFrame(CatchUpPosition);
+	}
+	PlayInternal();
+}
+
 void UGameActionSequencePlayer::JumpToFrame(FFrameTime NewPosition)
 {
 	UpdateTimeCursorPosition(NewPosition, EUpdatePositionMethod::Jump);
@@ -756,7 +787,11 @@ void UGameActionSequencePlayer::UpdateMovieSceneInstance(FMovieSceneEvaluationRa
 	FMovieSceneContext Context(InRange, PlayerStatus);
 	Context.SetHasJumped(bHasJumped);
 
-	RootTemplateInstance.Evaluate(Context, *this);
+	{
+		// 求值中触发的原生帧事件在作用域结束时合并执行
+		FGameActionNativeEventBatchScope NativeEventBatchScope;
+		RootTemplateInstance.Evaluate(Context, *this);
+	}
 
 	bIsEvaluating = false;
 
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/GameActionDebugEvents.h"
+#include <Engine/World.h>
+#include <Misc/ScopeLock.h>
+
+#include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionSegment.h"
+
+#if WITH_EDITOR
+TArray<FGameActionDebugEventListener*> FGameActionDebugEventListener::Listeners;
+FCriticalSection FGameActionDebugEventListener::ListenersCriticalSection;
+TAtomic<int32> FGameActionDebugEventListener::DebuggingListenerNum(0);
+
+FGameActionDebugEventListener::FGameActionDebugEventListener()
+{
+	FScopeLock ScopeLock(&ListenersCriticalSection);
+	Listeners.Add(this);
+}
+
+FGameActionDebugEventListener::~FGameActionDebugEventListener()
+{
+	FScopeLock ScopeLock(&ListenersCriticalSection);
+	Listeners.RemoveSingleSwap(this);
+	if (DebugInstance.IsExplicitlyNull() == false)
+	{
+		DebuggingListenerNum -= 1;
+	}
+}
+
+void FGameActionDebugEventListener::SetDebugInstance(UGameActionInstanceBase* Instance)
+{
+	FScopeLock ScopeLock(&ListenersCriticalSection);
+	const bool bWasDebugging = DebugInstance.IsExplicitlyNull() == false;
+	DebugInstance = Instance;
+	const bool bIsDebugging = DebugInstance.IsExplicitlyNull() == false;
+	if (bWasDebugging != bIsDebugging)
+	{
+		DebuggingListenerNum += bIsDebugging ? 1 : -1;
+	}
+}
+
+void FGameActionDebugEventListener::Publish(FGameActionDebugEvent::EType Type, UGameActionSegmentBase* Segment)
+{
+	if (DebuggingListenerNum.Load() == 0)
+	{
+		return;
+	}
+
+	UGameActionInstanceBase* Instance = Segment->GetOwner();
+	FGameActionDebugEvent Event;
+	Event.Type = Type;
+	Event.Instance = Instance;
+	Event.Segment = Segment;
+	if (const UWorld* World = Segment->GetWorld())
+	{
+		Event.WorldTime = World->GetTimeSeconds();
+	}
+	FScopeLock ScopeLock(&ListenersCriticalSection);
+	for (FGameActionDebugEventListener* Listener : Listeners)
+	{
+		if (Listener->DebugInstance == Instance)
+		{
+			Listener->EventQueue.Enqueue(Event);
+		}
+	}
+}
+#endif
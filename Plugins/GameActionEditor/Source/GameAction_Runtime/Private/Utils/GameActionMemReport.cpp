@@ -0,0 +1,253 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/GameActionMemReport.h"
+#include <UObject/UObjectIterator.h>
+#include <Serialization/ArchiveCountMem.h>
+#include <HAL/IConsoleManager.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <GameFramework/Actor.h>
+#include <Compilation/MovieSceneCompiledDataManager.h>
+#include <Evaluation/MovieSceneEvaluationTemplate.h>
+
+#include "GameAction/GameActionComponent.h"
+#include "GameAction/GameActionEvent.h"
+#include "GameAction/GameActionInstance.h"
+#include "GameAction/GameActionSegment.h"
+#include "Sequence/GameActionSequence.h"
+#include "Sequence/GameActionSequencePlayer.h"
+#include "Utils/GameAction_Log.h"
+
+namespace GameActionMemReportUtils
+{
+	SIZE_T GetExclusiveSize(UObject* Object)
+	{
+		FArchiveCountMem CountMem(Object);
+		return CountMem.GetMax();
+	}
+
+	SIZE_T GetInclusiveSize(UObject* Object)
+	{
+		SIZE_T Size = GetExclusiveSize(Object);
+		ForEachObjectWithOuter(Object, [&](UObject* Inner)
+		{
+			Size += GetExclusiveSize(Inner);
+		}, true);
+		return Size;
+	}
+
+	void AddToCategory(FGameActionMemReport::FCategoryStat& Category, UObject* Object)
+	{
+		const SIZE_T ExclusiveBytes = GetExclusiveSize(Object);
+		const SIZE_T InclusiveBytes = GetInclusiveSize(Object);
+
+		FGameActionMemReport::FClassStat& ClassStat = Category.ClassStats.FindOrAdd(Object->GetClass()->GetName());
+		ClassStat.Count += 1;
+		ClassStat.ExclusiveBytes += ExclusiveBytes;
+		ClassStat.InclusiveBytes += InclusiveBytes;
+
+		Category.Total.Count += 1;
+		Category.Total.ExclusiveBytes += ExclusiveBytes;
+		Category.Total.InclusiveBytes += InclusiveBytes;
+	}
+
+	SIZE_T GetEvaluationTemplateSize(const FMovieSceneEvaluationTemplate& Template)
+	{
+		SIZE_T Size = sizeof(FMovieSceneEvaluationTemplate);
+		for (const TPair<FMovieSceneTrackIdentifier, FMovieSceneEvaluationTrack>& Pair : Template.GetTracks())
+		{
+			Size += sizeof(FMovieSceneEvaluationTrack);
+			for (const FMovieSceneEvalTemplatePtr& ChildTemplate : Pair.Value.GetChildTemplates())
+			{
+				if (ChildTemplate.IsValid())
+				{
+					Size += ChildTemplate->GetScriptStruct().GetStructureSize();
+				}
+			}
+		}
+		return Size;
+	}
+}
+
+void FGameActionMemReport::Gather(const UWorld* World, bool bIncludeTemplates)
+{
+	using namespace GameActionMemReportUtils;
+
+	Categories.Reset();
+	EvaluationTemplateCount = 0;
+	EvaluationTemplateBytes = 0;
+
+	// 模板对象没有所属的世界，只在不指定世界时统计
+	const auto IsInReportScope = [&](UObject* Object)
+	{
+		if (Object->IsTemplate() || Object->IsPendingKill())
+		{
+			return bIncludeTemplates && World == nullptr && Object->IsPendingKill() == false;
+		}
+		return World == nullptr || Object->GetWorld() == World;
+	};
+
+	FCategoryStat& ComponentCategory = Categories.AddDefaulted_GetRef();
+	ComponentCategory.Category = TEXT("Component");
+	for (TObjectIterator<UGameActionComponent> It; It; ++It)
+	{
+		if (IsInReportScope(*It))
+		{
+			AddToCategory(ComponentCategory, *It);
+		}
+	}
+
+	TSet<AActor*> SpawnedActors;
+	FCategoryStat& InstanceCategory = Categories.AddDefaulted_GetRef();
+	InstanceCategory.Category = TEXT("Instance");
+	for (TObjectIterator<UGameActionInstanceBase> It; It; ++It)
+	{
+		if (IsInReportScope(*It))
+		{
+			AddToCategory(InstanceCategory, *It);
+			SpawnedActors.Append(It->InstanceManagedSpawnables);
+		}
+	}
+
+	// 共享的序列只统计一次
+	TSet<UGameActionSequence*> Sequences;
+	FCategoryStat& SegmentCategory = Categories.AddDefaulted_GetRef();
+	SegmentCategory.Category = TEXT("Segment");
+	for (TObjectIterator<UGameActionSegmentBase> It; It; ++It)
+	{
+		if (IsInReportScope(*It))
+		{
+			AddToCategory(SegmentCategory, *It);
+			if (UGameActionSegment* Segment = Cast<UGameActionSegment>(*It))
+			{
+				// 延迟加载的序列未加载时不计入
+				UGameActionSequence* Sequence = Segment->bLazyLoadSequence ? Segment->LazyGameActionSequence.Get() : Segment->GameActionSequence;
+				if (Sequence)
+				{
+					Sequences.Add(Sequence);
+				}
+			}
+		}
+	}
+
+	FCategoryStat& SequenceCategory = Categories.AddDefaulted_GetRef();
+	SequenceCategory.Category = TEXT("Sequence");
+	UMovieSceneCompiledDataManager* CompiledDataManager = UMovieSceneCompiledDataManager::GetPrecompiledData();
+	for (UGameActionSequence* Sequence : Sequences)
+	{
+		AddToCategory(SequenceCategory, Sequence);
+
+		const FMovieSceneCompiledDataID DataID = CompiledDataManager->FindDataID(Sequence);
+		if (DataID.IsValid())
+		{
+			if (const FMovieSceneEvaluationTemplate* Template = CompiledDataManager->FindTrackTemplate(DataID))
+			{
+				EvaluationTemplateCount += 1;
+				EvaluationTemplateBytes += GetEvaluationTemplateSize(*Template);
+			}
+		}
+	}
+
+	FCategoryStat& PlayerCategory = Categories.AddDefaulted_GetRef();
+	PlayerCategory.Category = TEXT("Player");
+	for (TObjectIterator<UGameActionSequencePlayer> It; It; ++It)
+	{
+		if (IsInReportScope(*It))
+		{
+			AddToCategory(PlayerCategory, *It);
+			for (const TPair<TWeakObjectPtr<AActor>, const UGameActionSequenceSpawnerSettingsBase*>& Pair : It->GetSpawnOwnershipMap())
+			{
+				if (AActor* Actor = Pair.Key.Get())
+				{
+					SpawnedActors.Add(Actor);
+				}
+			}
+		}
+	}
+
+	// 只统计运行时实例化出的状态事件（包含组件对象池中的），Section中的模板在包含模板时统计
+	FCategoryStat& StateEventCategory = Categories.AddDefaulted_GetRef();
+	StateEventCategory.Category = TEXT("StateEvent");
+	for (TObjectIterator<UGameActionStateEvent> It; It; ++It)
+	{
+		const bool bIsRuntimeInstance = (It->GetOuter()->IsA<UGameActionInstanceBase>() || It->GetOuter()->IsA<UGameActionComponent>()) && It->IsTemplate() == false;
+		if ((bIsRuntimeInstance || bIncludeTemplates) && IsInReportScope(*It))
+		{
+			AddToCategory(StateEventCategory, *It);
+		}
+	}
+
+	FCategoryStat& SpawnedActorCategory = Categories.AddDefaulted_GetRef();
+	SpawnedActorCategory.Category = TEXT("SpawnedActor");
+	for (AActor* Actor : SpawnedActors)
+	{
+		if (::IsValid(Actor) && IsInReportScope(Actor))
+		{
+			AddToCategory(SpawnedActorCategory, Actor);
+		}
+	}
+
+	for (FCategoryStat& Category : Categories)
+	{
+		Category.ClassStats.ValueSort([](const FClassStat& LHS, const FClassStat& RHS) { return LHS.InclusiveBytes > RHS.InclusiveBytes; });
+	}
+}
+
+void FGameActionMemReport::Print(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("GameAction MemReport"));
+	for (const FCategoryStat& Category : Categories)
+	{
+		Ar.Logf(TEXT("[%s] Count: %d Exclusive: %.2fKB Inclusive: %.2fKB"), *Category.Category, Category.Total.Count, Category.Total.ExclusiveBytes / 1024.f, Category.Total.InclusiveBytes / 1024.f);
+		for (const TPair<FString, FClassStat>& Pair : Category.ClassStats)
+		{
+			Ar.Logf(TEXT("    %s Count: %d Exclusive: %.2fKB Inclusive: %.2fKB"), *Pair.Key, Pair.Value.Count, Pair.Value.ExclusiveBytes / 1024.f, Pair.Value.InclusiveBytes / 1024.f);
+		}
+	}
+	Ar.Logf(TEXT("[EvaluationTemplate] Count: %d Size: %.2fKB"), EvaluationTemplateCount, EvaluationTemplateBytes / 1024.f);
+}
+
+bool FGameActionMemReport::SaveCsv(const FString& FilePath) const
+{
+	FString Csv = TEXT("Category,Class,Count,ExclusiveBytes,InclusiveBytes\n");
+	for (const FCategoryStat& Category : Categories)
+	{
+		Csv += FString::Printf(TEXT("%s,Total,%d,%llu,%llu\n"), *Category.Category, Category.Total.Count, (uint64)Category.Total.ExclusiveBytes, (uint64)Category.Total.InclusiveBytes);
+		for (const TPair<FString, FClassStat>& Pair : Category.ClassStats)
+		{
+			Csv += FString::Printf(TEXT("%s,%s,%d,%llu,%llu\n"), *Category.Category, *Pair.Key, Pair.Value.Count, (uint64)Pair.Value.ExclusiveBytes, (uint64)Pair.Value.InclusiveBytes);
+		}
+	}
+	Csv += FString::Printf(TEXT("EvaluationTemplate,Total,%d,%llu,%llu\n"), EvaluationTemplateCount, (uint64)EvaluationTemplateBytes, (uint64)EvaluationTemplateBytes);
+	return FFileHelper::SaveStringToFile(Csv, *FilePath);
+}
+
+FString FGameActionMemReport::MakeDefaultCsvPath()
+{
+	return FPaths::Combine(FPaths::ProfilingDir(), TEXT("GameAction"), FString::Printf(TEXT("MemReport-%s.csv"), *FDateTime::Now().ToString()));
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GameActionMemReportCommand(
+	TEXT("GameAction.MemReport"),
+	TEXT("统计当前世界中GameAction相关对象的数量与内存占用。-csv 输出至Saved/Profiling/GameAction，-templates 包含模板对象"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const bool bIncludeTemplates = Args.Contains(TEXT("-templates"));
+		FGameActionMemReport MemReport;
+		MemReport.Gather(bIncludeTemplates ? nullptr : World, bIncludeTemplates);
+		MemReport.Print(Ar);
+
+		if (Args.Contains(TEXT("-csv")))
+		{
+			const FString CsvPath = FGameActionMemReport::MakeDefaultCsvPath();
+			if (MemReport.SaveCsv(CsvPath))
+			{
+				Ar.Logf(TEXT("GameAction MemReport已保存至%s"), *CsvPath);
+			}
+			else
+			{
+				GameAction_Log(Warning, "GameAction MemReport保存至%s失败", *CsvPath);
+			}
+		}
+	}));
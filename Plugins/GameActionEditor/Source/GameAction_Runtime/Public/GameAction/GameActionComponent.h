@@ -5,12 +5,30 @@
 #include "CoreMinimal.h"
 #include "GameActionType.h"
 #include "Components/ActorComponent.h"
+#include "GameplayTagContainer.h"
 #include "Templates/SubclassOf.h"
 #include "GameActionComponent.generated.h"
 
 class UGameActionSegmentBase;
 class UGameActionInstanceBase;
 class UGameActionSequencePlayer;
+class UGameActionStateEvent;
+class FGameActionReplayRecorder;
+class FGameActionReplayPlayback;
+enum class EGameActionReplayRecordType : uint8;
+
+USTRUCT()
+struct FGameActionStateEventPool
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(Transient)
+	TArray<UGameActionStateEvent*> FreeInstances;
+
+	// 使用中的实例也由对象池持有引用，防止被GC
+	UPROPERTY(Transient)
+	TArray<UGameActionStateEvent*> UsedInstances;
+};
 
 UCLASS(ClassGroup=(Gameplay), meta=(BlueprintSpawnableComponent))
 class GAMEACTION_RUNTIME_API UGameActionComponent : public UActorComponent
@@ -87,4 +105,39 @@ public:
 	UGameActionInstanceBase* GetSharedPlayerActiveAction() const;
 	UFUNCTION(BlueprintCallable, Category = "GameAction")
 	void AbortSharedPlayerActiveAction();
+
+public:
+	// 由行为状态事件添加的标签，按引用计数，所有添加者都移除后标签才消失
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Transient, Category = "GameAction")
+	FGameplayTagContainer GameActionTags;
+
+	UFUNCTION(BlueprintCallable, Category = "GameAction")
+	bool HasGameActionTag(FGameplayTag Tag) const { return GameActionTags.HasTag(Tag); }
+
+	void AddGameActionTags(const FGameplayTagContainer& Tags);
+	void RemoveGameActionTags(const FGameplayTagContainer& Tags);
+	// 任意组件的标签变化时递增，依赖标签的跳转条件据此判断是否需要重新求值
+	static uint32 GetGameActionTagsSerial() { return GameActionTagsSerial; }
+
+	// 实例化的状态事件按模板放入对象池，重复激活时不再创建对象
+	// 同类不同模板的实例化子对象各不相同，按类共用会让实例保留其它模板的子对象
+	UGameActionStateEvent* AcquireStateEventInstance(const UGameActionStateEvent* Template);
+	void ReleaseStateEventInstance(const UGameActionStateEvent* Template, UGameActionStateEvent* Instance);
+private:
+	UPROPERTY(Transient)
+	TMap<const UGameActionStateEvent*, FGameActionStateEventPool> StateEventPools;
+
+	TMap<FGameplayTag, int32> GameActionTagCounts;
+	static uint32 GameActionTagsSerial;
+
+public:
+	// 行为在录像中以紧凑的行为流记录，实例与播放器不写入录像，回放时按记录在本地创建实例播放
+	void RecordReplay(EGameActionReplayRecordType Type, UGameActionInstanceBase* Instance, UGameActionSegmentBase* Segment);
+	UGameActionInstanceBase* FindOrAddReplayInstance(const FString& ClassPath);
+	void FlushReplay();
+private:
+	void TickReplay();
+
+	TSharedPtr<FGameActionReplayRecorder> ReplayRecorder;
+	TSharedPtr<FGameActionReplayPlayback> ReplayPlayback;
 };
@@ -48,6 +48,9 @@ protected:
 	friend class UGameActionStateInnerKeyEvent;
 	UPROPERTY(Transient)
 	mutable UObject* WorldContentObject = nullptr;
+
+	// 原生事件直接调用C++实现，不需要蓝图脚本执行保护
+	uint8 bNativeEvent : 1;
 };
 
 UCLASS(abstract, const, Blueprintable, meta = (DisplayName = "游戏行为帧事件"))
@@ -79,6 +82,10 @@ public:
 
 	UPROPERTY(EditDefaultsOnly, Category = "设置", meta = (DisplayName = "实例化"))
 	uint8 bInstanced : 1;
+
+	// 实例化的事件从对象池取出复用时调用，将状态还原为模板的值
+	// Transient的属性还原为类默认值，实例化引用的属性不还原，实例化的子对象仍是该实例独有的，其中的状态需要子类重载后自行还原
+	virtual void ResetInstance(const UGameActionStateEvent* Template);
 protected:
 	virtual void WhenEventStart(UObject* EventOwner, IMovieScenePlayer& Player);
 	virtual void WhenEventTick(UObject* EventOwner, IMovieScenePlayer& Player, float DeltaSeconds);
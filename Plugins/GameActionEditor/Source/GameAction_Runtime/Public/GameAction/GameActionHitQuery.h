@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameAction/GameActionEvent.h"
+#include "GameActionHitQuery.generated.h"
+
+/**
+ * 世界内所有攻击判定的物理查询统一经由异步查询队列发出，结果在下一次求值时取回
+ * 同一帧提交的查询由引擎按批分派至工作线程，与游戏线程的其余逻辑并行执行
+ */
+UCLASS()
+class GAMEACTION_RUNTIME_API UGameActionHitQuerySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	static UGameActionHitQuerySubsystem* Get(const UObject* WorldContextObject);
+
+	FTraceHandle SubmitSweep(const FVector& Start, const FVector& End, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor);
+	FTraceHandle SubmitOverlap(const FVector& Location, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor);
+
+	// 查询尚未完成或已过期时返回假，重叠查询的结果转为不阻挡的命中结果
+	// 异步查询在提交的下一帧才可读取，调用方需保证不在提交的同一帧取回
+	bool ConsumeResults(const FTraceHandle& Handle, bool bIsOverlap, TArray<FHitResult>& OutHits) const;
+
+	// 同步查询，用于状态结束时无法再等待下一帧的最后一次判定
+	void Sweep(const FVector& Start, const FVector& End, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor, TArray<FHitResult>& OutHits) const;
+	void Overlap(const FVector& Location, const FQuat& Rotation, ECollisionChannel TraceChannel, const FCollisionShape& Shape, const AActor* IgnoreActor, TArray<FHitResult>& OutHits) const;
+};
+
+UENUM()
+enum class EGameActionHitQueryShape : uint8
+{
+	Sphere,
+	Capsule,
+	Box
+};
+
+/**
+ * 攻击判定状态，每次求值提交一次异步查询，命中在之后帧的求值中派发
+ * 结束时未能取回的查询与最后一段位移改为同步查询，同一次激活中每个Actor只命中一次
+ */
+UCLASS(meta = (DisplayName = "攻击判定"))
+class GAMEACTION_RUNTIME_API UGameActionStateEvent_HitQuery : public UGameActionStateEvent
+{
+	GENERATED_BODY()
+public:
+	UGameActionStateEvent_HitQuery();
+
+	UPROPERTY(EditAnywhere, Category = "判定")
+	EGameActionHitQueryShape Shape = EGameActionHitQueryShape::Sphere;
+
+	UPROPERTY(EditAnywhere, Category = "判定", meta = (EditCondition = "Shape != EGameActionHitQueryShape::Box"))
+	float Radius = 30.f;
+
+	UPROPERTY(EditAnywhere, Category = "判定", meta = (EditCondition = "Shape == EGameActionHitQueryShape::Capsule"))
+	float HalfHeight = 60.f;
+
+	UPROPERTY(EditAnywhere, Category = "判定", meta = (EditCondition = "Shape == EGameActionHitQueryShape::Box"))
+	FVector BoxExtent = FVector(30.f);
+
+	UPROPERTY(EditAnywhere, Category = "判定")
+	FName SocketName;
+
+	UPROPERTY(EditAnywhere, Category = "判定")
+	FVector LocationOffset = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, Category = "判定")
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Pawn;
+
+	// 从上一次求值的位置扫掠至当前位置，避免高速挥砍穿过目标，关闭时只检测当前位置的重叠
+	UPROPERTY(EditAnywhere, Category = "判定", meta = (DisplayName = "扫掠"))
+	uint8 bSweep : 1;
+
+	// 本次激活已命中的Actor
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "判定")
+	TArray<AActor*> HitActors;
+
+	void ResetInstance(const UGameActionStateEvent* Template) override;
+protected:
+	void WhenEventStart(UObject* EventOwner, IMovieScenePlayer& Player) override;
+	void WhenEventTick(UObject* EventOwner, IMovieScenePlayer& Player, float DeltaSeconds) override;
+	void WhenEventEnd(UObject* EventOwner, IMovieScenePlayer& Player, bool bIsCompleted) override;
+
+	virtual void WhenHit(UObject* EventOwner, const FHitResult& Hit, IMovieScenePlayer& Player);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Event")
+	void ReceiveWhenHit(UObject* EventOwner, const FHitResult& Hit, UGameActionInstanceBase* GameActionInstance);
+private:
+	// 查询仍在等待下一帧时返回假并保留句柄
+	bool ConsumePendingQuery(UObject* EventOwner, IMovieScenePlayer& Player);
+	void SubmitQuery(UObject* EventOwner);
+	void FinalQuery(UObject* EventOwner, IMovieScenePlayer& Player);
+	void DispatchHits(UObject* EventOwner, IMovieScenePlayer& Player, const TArray<FHitResult>& Results);
+	FCollisionShape MakeCollisionShape() const;
+	bool GetQueryTransform(UObject* EventOwner, FVector& OutLocation, FQuat& OutRotation, const AActor*& OutIgnoreActor) const;
+
+	FTraceHandle PendingHandle;
+	uint64 PendingFrame;
+	uint8 bPendingIsOverlap : 1;
+	uint8 bHasPreviousLocation : 1;
+	FVector PendingStartLocation;
+	FVector PreviousLocation;
+	// 未取回的查询过期时按提交时的朝向重做
+	FQuat PendingRotation;
+};
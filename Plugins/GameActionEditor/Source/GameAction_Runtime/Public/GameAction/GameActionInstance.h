@@ -59,6 +59,11 @@ public:
 	UPROPERTY()
 	UGameActionSequencePlayer* SequencePlayer = nullptr;
 
+	// 开启后实例中的行为片段直接引用类默认对象中的序列数据，不再为每个实例复制Sequence与MovieScene
+	// 运行时序列数据只读，大量NPC使用同一行为时可显著减少UObject数量
+	UPROPERTY(EditDefaultsOnly, Category = "配置", meta = (DisplayName = "共享序列数据"))
+	uint8 bShareSequenceData : 1;
+
 	UPROPERTY(EditAnywhere, Category = "配置")
 	float SubStepDuration = 1.f / 60.f;
 	uint8 EnableSubStepMode = 0;
@@ -71,6 +76,20 @@ public:
 	UGameActionSegmentBase* ActivedSegment = nullptr;
 	UFUNCTION()
 	void OnRep_ActivedSegment(UGameActionSegmentBase* PreActivedSegment);
+	// 服务端激活当前片段时的服务器时间，模拟端晚加入或进入相关范围时据此从服务器的进度开始播放
+	UPROPERTY(Replicated)
+	float ActivedServerWorldTime = 0.f;
+	// 晚加入或进入相关范围时的首次激活扣除单程延迟后仍落后服务器超过该时长才追赶，否则由网络同步修正
+	static constexpr float CatchUpActivationThreshold = 0.1f;
+	// 片段激活时取走需要追赶的时长，之后的激活从头播放
+	float ConsumeCatchUpSeconds();
+	float GetServerWorldTimeSeconds() const;
+	// 按本地玩家的往返延迟估算，服务器时间与激活时间都会晚这么久到达
+	float GetEstimatedOneWayLatency() const;
+	// 所属Actor正在处理打开通道的初始数据包
+	bool IsOwnerNetInitializing() const;
+	// 片段已播放的时长超过阈值时从该进度开始播放，不重放之前的帧事件与生成
+	void ActiveSegmentWithCatchUp(UGameActionSegmentBase* Segment, float ElapsedSeconds);
 
 	UFUNCTION(BlueprintCallable, Category = "GameAction")
 	bool TryStartEntry(const FGameActionEntry& Entry);
@@ -82,6 +101,17 @@ public:
 	bool IsActived() const { return ActivedSegment != nullptr; }
 	UFUNCTION(BlueprintCallable, Category = "GameAction")
 	bool TryEventTransition(FName EventName);
+	// 跳转失败时事件缓存BufferDuration秒，之后每帧重试，成功后消耗；返回值只表示本次是否跳转成功
+	// BufferDuration小于0时使用配置的事件缓存时长，等于0时不缓存
+	UFUNCTION(BlueprintCallable, Category = "GameAction")
+	bool TryEventTransitionWithBuffer(FName EventName, float BufferDuration = -1.f);
+	UFUNCTION(BlueprintCallable, Category = "GameAction")
+	void ClearBufferedEvents() { BufferedEvents.Reset(); }
+
+	// TryEventTransitionWithBuffer跳转失败后输入事件保留的时长，使连招输入落在最早可跳转的帧上，为0时不缓存
+	UPROPERTY(EditDefaultsOnly, Category = "配置", meta = (DisplayName = "事件缓存时长"))
+	float EventBufferDuration = 0.15f;
+	static constexpr int32 MaxBufferedEventNum = 4;
 
 	void ConstructInstance();
 	void ActiveInstance();
@@ -95,6 +125,14 @@ public:
 	UPROPERTY(Transient)
 	TArray<AActor*> InstanceManagedSpawnables;
 
+	// 子对象绑定的解析缓存，只有绑定的Actor属性变化后才重新解析
+	struct FResolvedSubobjectBinding
+	{
+		TWeakObjectPtr<AActor> OwnerActor;
+		TWeakObjectPtr<UObject> Subobject;
+	};
+	TMap<FGuid, FResolvedSubobjectBinding> ResolvedSubobjectBindings;
+
 #if WITH_EDITORONLY_DATA
 	uint8 bIsSimulation : 1;
 
@@ -138,6 +176,18 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "GameAction", meta = (CompactNodeTitle = "To World", HidePin = "Target"))
 	void TransformActorData(const FGameActionPossessableActorData& ActorData, FVector& WorldLocation, FRotator& WorldRotation) const;
 
+private:
+	struct FBufferedEvent
+	{
+		FName EventName;
+		float Timestamp;
+		float ExpireTime;
+	};
+	TArray<FBufferedEvent, TInlineAllocator<MaxBufferedEventNum>> BufferedEvents;
+	void BufferEvent(const FName& EventName, float BufferDuration);
+	void RetryBufferedEvents();
+
+	float PendingCatchUpSeconds = 0.f;
 public:
 	void ActionTransition(UGameActionSegmentBase* FromSegment, UGameActionSegmentBase* ToSegement);
 	void RollbackTransition(UGameActionSegmentBase* FromSegment, UGameActionSegmentBase* ToSegement);
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "GameAction/GameActionEvent.h"
+#include "GameActionNativeEvents.generated.h"
+
+class USoundBase;
+class UNiagaraSystem;
+class UDamageType;
+class UCameraShakeBase;
+
+/**
+ * 常用事件的原生实现，不经过蓝图虚拟机
+ * 播放器求值期间触发的原生帧事件先收集，求值结束后按类型合并执行
+ */
+struct GAMEACTION_RUNTIME_API FGameActionNativeEventBatchScope
+{
+	FGameActionNativeEventBatchScope();
+	~FGameActionNativeEventBatchScope();
+};
+
+UCLASS(meta = (DisplayName = "播放音效"))
+class GAMEACTION_RUNTIME_API UGameActionKeyEvent_PlaySound : public UGameActionKeyEvent
+{
+	GENERATED_BODY()
+public:
+	UGameActionKeyEvent_PlaySound();
+
+	FString GetEventName() const override;
+
+	UPROPERTY(EditAnywhere, Category = "音效")
+	USoundBase* Sound = nullptr;
+
+	UPROPERTY(EditAnywhere, Category = "音效")
+	FName SocketName;
+
+	UPROPERTY(EditAnywhere, Category = "音效", meta = (DisplayName = "跟随挂点"))
+	uint8 bAttach : 1;
+
+	UPROPERTY(EditAnywhere, Category = "音效")
+	float VolumeMultiplier = 1.f;
+
+	UPROPERTY(EditAnywhere, Category = "音效")
+	float PitchMultiplier = 1.f;
+protected:
+	void WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const override;
+};
+
+UCLASS(meta = (DisplayName = "挂点生成Niagara特效"))
+class GAMEACTION_RUNTIME_API UGameActionKeyEvent_SpawnNiagara : public UGameActionKeyEvent
+{
+	GENERATED_BODY()
+public:
+	UGameActionKeyEvent_SpawnNiagara();
+
+	FString GetEventName() const override;
+
+	UPROPERTY(EditAnywhere, Category = "特效")
+	UNiagaraSystem* System = nullptr;
+
+	UPROPERTY(EditAnywhere, Category = "特效")
+	FName SocketName;
+
+	UPROPERTY(EditAnywhere, Category = "特效")
+	FVector LocationOffset = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, Category = "特效")
+	FRotator RotationOffset = FRotator::ZeroRotator;
+
+	UPROPERTY(EditAnywhere, Category = "特效", meta = (DisplayName = "跟随挂点"))
+	uint8 bAttach : 1;
+protected:
+	void WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const override;
+};
+
+UCLASS(meta = (DisplayName = "范围伤害"))
+class GAMEACTION_RUNTIME_API UGameActionKeyEvent_ApplyDamage : public UGameActionKeyEvent
+{
+	GENERATED_BODY()
+public:
+	UGameActionKeyEvent_ApplyDamage();
+
+	UPROPERTY(EditAnywhere, Category = "伤害")
+	float BaseDamage = 10.f;
+
+	UPROPERTY(EditAnywhere, Category = "伤害")
+	float DamageRadius = 100.f;
+
+	UPROPERTY(EditAnywhere, Category = "伤害")
+	FName SocketName;
+
+	UPROPERTY(EditAnywhere, Category = "伤害")
+	TSubclassOf<UDamageType> DamageType;
+
+	UPROPERTY(EditAnywhere, Category = "伤害", meta = (DisplayName = "无衰减"))
+	uint8 bDoFullDamage : 1;
+protected:
+	void WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const override;
+};
+
+UCLASS(meta = (DisplayName = "镜头震动"))
+class GAMEACTION_RUNTIME_API UGameActionKeyEvent_CameraShake : public UGameActionKeyEvent
+{
+	GENERATED_BODY()
+public:
+	UGameActionKeyEvent_CameraShake();
+
+	FString GetEventName() const override;
+
+	UPROPERTY(EditAnywhere, Category = "镜头")
+	TSubclassOf<UCameraShakeBase> CameraShake;
+
+	UPROPERTY(EditAnywhere, Category = "镜头")
+	float Scale = 1.f;
+
+	// 外半径为0时只震动事件所有者自己的镜头
+	UPROPERTY(EditAnywhere, Category = "镜头")
+	float InnerRadius = 0.f;
+
+	UPROPERTY(EditAnywhere, Category = "镜头")
+	float OuterRadius = 0.f;
+protected:
+	void WhenEventExecute(UObject* EventOwner, IMovieScenePlayer& Player) const override;
+};
+
+// 状态期间为所有者的GameActionComponent添加标签，状态结束时移除
+UCLASS(meta = (DisplayName = "添加GameplayTag"))
+class GAMEACTION_RUNTIME_API UGameActionStateEvent_AddGameplayTags : public UGameActionStateEvent
+{
+	GENERATED_BODY()
+public:
+	UGameActionStateEvent_AddGameplayTags();
+
+	FString GetEventName() const override;
+
+	UPROPERTY(EditAnywhere, Category = "标签")
+	FGameplayTagContainer Tags;
+protected:
+	void WhenEventStart(UObject* EventOwner, IMovieScenePlayer& Player) override;
+	void WhenEventTick(UObject* EventOwner, IMovieScenePlayer& Player, float DeltaSeconds) override {}
+	void WhenEventEnd(UObject* EventOwner, IMovieScenePlayer& Player, bool bIsCompleted) override;
+};
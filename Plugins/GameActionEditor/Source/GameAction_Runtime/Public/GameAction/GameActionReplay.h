@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/NetworkGuid.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameActionReplay.generated.h"
+
+class UDemoNetDriver;
+class UGameActionComponent;
+class UGameActionInstanceBase;
+class UGameActionSegmentBase;
+
+/**
+ * 录像中的行为流
+ * 行为实例、片段与播放器不再通过属性同步写入录像，每个角色的激活、跳转与结束记录为紧凑的增量编码，按固定间隔切分为数据块作为录像事件写入
+ * 数据块以关键帧开头，记录各实例当前激活的片段与激活时间，之后的记录只保存与前一条的时间差和名字表索引
+ */
+enum class EGameActionReplayRecordType : uint8
+{
+	// 实例已激活时为片段间的跳转
+	Actived,
+	Deactived,
+	Aborted
+};
+
+struct FGameActionReplayRecord
+{
+	EGameActionReplayRecordType Type;
+	float Time;
+	int32 InstanceName;
+	int32 SegmentName;
+};
+
+struct FGameActionReplayState
+{
+	int32 InstanceName;
+	int32 SegmentName;
+	float ActivedTime;
+};
+
+struct FGameActionReplayChunk
+{
+	float StartTime = 0.f;
+	// 实例类路径与片段名，数据块内的记录只引用索引
+	TArray<FString> Names;
+	TArray<FGameActionReplayState> Keyframe;
+	TArray<FGameActionReplayRecord> Records;
+
+	void Serialize(FArchive& Ar, FNetworkGUID& OwnerGuid);
+	int32 FindOrAddName(const FString& Name);
+};
+
+// 录制端，每个组件录制时持有一份
+class FGameActionReplayRecorder
+{
+public:
+	// 新数据块只在追加记录时按间隔开启，静止的角色不产生数据
+	static constexpr float KeyframeInterval = 10.f;
+	// 数据块写入事件需重新序列化整块，追加的记录在数据块关闭、间隔到达或停止录制时才写入
+	static constexpr float FlushInterval = 1.f;
+
+	void Tick(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver);
+	void Record(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver, EGameActionReplayRecordType Type, UGameActionInstanceBase* Instance, UGameActionSegmentBase* Segment);
+	// 写入未写入的记录
+	void Flush(UDemoNetDriver* DemoNetDriver);
+private:
+	void BeginChunk(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver);
+
+	struct FInstanceState
+	{
+		FString SegmentName;
+		float ActivedTime;
+	};
+	TMap<FString, FInstanceState> ActivedStates;
+
+	FNetworkGUID OwnerGuid;
+	FGameActionReplayChunk Chunk;
+	int32 ChunkIndex = INDEX_NONE;
+	float LastFlushTime = 0.f;
+	bool bDirty = false;
+};
+
+// 回放端，时间连续前进时逐条执行记录，时间跳变时从最近的关键帧推进到目标时间后直接从该进度开始播放
+class FGameActionReplayPlayback
+{
+public:
+	// 两次更新间隔超过该值视为拖动进度
+	static constexpr float SeekThreshold = 0.5f;
+
+	void Update(UGameActionComponent* Component, UDemoNetDriver* DemoNetDriver);
+private:
+	void Seek(UGameActionComponent* Component, float Time);
+	void ApplyRecord(UGameActionComponent* Component, const FGameActionReplayChunk& RecordChunk, const FGameActionReplayRecord& Record, float Time);
+
+	const TArray<FGameActionReplayChunk>* Chunks = nullptr;
+	int32 ChunkIndex = 0;
+	int32 RecordIndex = 0;
+	float LastTime = -1.f;
+};
+
+UCLASS()
+class GAMEACTION_RUNTIME_API UGameActionReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	UGameActionReplaySubsystem();
+
+	static UGameActionReplaySubsystem* Get(const UObject* WorldContextObject);
+	static const FString ReplayEventGroup;
+
+	// 停止录制前调用，写入所有组件未写入的记录；关卡结束时组件会自行写入
+	UFUNCTION(BlueprintCallable, Category = "GameAction", meta = (WorldContext = "WorldContextObject"))
+	static void FlushRecording(const UObject* WorldContextObject);
+
+	// 第一次查询时请求录像中所有的行为数据块，全部取回前返回空
+	const TArray<FGameActionReplayChunk>* FindChunks(UDemoNetDriver* DemoNetDriver, const FNetworkGUID& OwnerGuid);
+private:
+	void RequestChunks(UDemoNetDriver* DemoNetDriver);
+	void AddChunkData(const TArray<uint8>& Data);
+
+	TMap<FNetworkGUID, TArray<FGameActionReplayChunk>> OwnerChunks;
+	int32 PendingRequestNum = 0;
+	uint8 bRequested : 1;
+};
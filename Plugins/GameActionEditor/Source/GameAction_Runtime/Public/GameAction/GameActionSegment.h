@@ -12,6 +12,39 @@ class UGameActionInstanceBase;
 class UGameActionSegmentBase;
 class ACharacter;
 
+USTRUCT()
+struct GAMEACTION_RUNTIME_API FGameActionTransitionTimeWindow
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY()
+	FFrameNumber Lower;
+	UPROPERTY()
+	FFrameNumber Upper;
+};
+
+// 编译时分析出的跳转条件依赖，依赖未变化时不需要重新求值条件
+USTRUCT()
+struct GAMEACTION_RUNTIME_API FGameActionTransitionDependency
+{
+	GENERATED_BODY()
+public:
+	FGameActionTransitionDependency()
+		: bUnknown(true), bOwnerTags(false)
+	{}
+
+	// 条件中存在无法分析的节点，每帧求值
+	UPROPERTY()
+	uint8 bUnknown : 1;
+	// 读取了GameActionComponent的标签
+	UPROPERTY()
+	uint8 bOwnerTags : 1;
+	UPROPERTY()
+	TArray<FName> InstanceVariables;
+	UPROPERTY()
+	TArray<FGameActionTransitionTimeWindow> TimeWindows;
+};
+
 /**
  * 
  */
@@ -19,6 +52,56 @@ USTRUCT(BlueprintType, BlueprintInternalUseOnly)
 struct GAMEACTION_RUNTIME_API FGameActionTickTransition : public FGameActionTransitionBase
 {
 	GENERATED_BODY()
+public:
+	UPROPERTY()
+	FGameActionTransitionDependency Dependency;
+};
+
+/**
+ * 记录Tick跳转条件的脏标记，只有条件的依赖变化或跨越时间窗口边界时才重新求值
+ * 依赖未知的条件与超出追踪上限的条件每帧求值
+ */
+struct GAMEACTION_RUNTIME_API FGameActionTickTransitionTracker
+{
+	static constexpr int32 MaxTrackedNum = 64;
+
+	FGameActionTickTransitionTracker() = default;
+	FGameActionTickTransitionTracker(const FGameActionTickTransitionTracker&) = delete;
+	FGameActionTickTransitionTracker& operator=(const FGameActionTickTransitionTracker&) = delete;
+	~FGameActionTickTransitionTracker() { ResetSnapshot(); }
+
+	// 片段激活时调用，记录依赖的当前值并标记所有条件需要求值
+	void Activate(const UGameActionSegmentBase* Segment);
+	// 收集自上次求值后依赖发生变化的条件
+	uint64 GatherDirtyMask(const UGameActionSegmentBase* Segment);
+	void ClearDirty(int32 TransitionIndex) { DirtyMask &= ~(uint64(1) << TransitionIndex); }
+private:
+	void Resolve(const UGameActionSegmentBase* Segment);
+	void ResetSnapshot();
+	uint64 GetInRangeMask(const UGameActionSegmentBase* Segment) const;
+
+	struct FVariable
+	{
+		const FProperty* Property;
+		int32 Offset;
+	};
+	TArray<FVariable> Variables;
+	TArray<uint8, TAlignedHeapAllocator<16>> Snapshot;
+
+	struct FTransition
+	{
+		uint64 VariableMask = 0;
+		uint64 TimeWindowMask = 0;
+		bool bOwnerTags = false;
+		bool bAlwaysDirty = false;
+	};
+	TArray<FTransition> Transitions;
+	TArray<FGameActionTransitionTimeWindow> TimeWindows;
+
+	uint64 DirtyMask = 0;
+	uint64 InRangeMask = 0;
+	uint32 OwnerTagsSerial = 0;
+	bool bResolved = false;
 };
 
 USTRUCT(BlueprintType, BlueprintInternalUseOnly)
@@ -63,6 +146,10 @@ public:
 
 	void TryFinishActionOrTransition();
 	bool InvokeEventTransition(const FName& EventName);
+
+	// 该片段可能即将被激活时调用，用于预先加载资源
+	virtual void PrefetchResources() {}
+	void PrefetchTransitionResources();
 protected:
 	virtual void WhenActionActived() { ReceiveWhenActionActived(); }
 	virtual void WhenActionAborted() { ReceiveWhenActionAborted(); }
@@ -107,6 +194,8 @@ public:
 	TArray<FGameActionTickTransition> TickTransitions;
 	UPROPERTY()
 	TArray<FGameActionEventTransition> EventTransitions;
+private:
+	FGameActionTickTransitionTracker TickTransitionTracker;
 
 protected:
 	UFUNCTION(Client, Reliable)
@@ -119,6 +208,10 @@ public:
 	UObject* BPNodeTemplate;
 	FORCEINLINE class UBPNode_GameActionSegmentBase* GetBPNodeTemplate() const { return (UBPNode_GameActionSegmentBase*)BPNodeTemplate; }
 
+	// 编译时记录的节点内容哈希，未变化时复用上次编译的模板
+	UPROPERTY()
+	uint32 CompiledContentHash = 0;
+
 	UPROPERTY(EditDefaultsOnly, Category = "配置")
 	TArray<FGameActionEventEntry> DefaultEvents;
 #endif
@@ -142,6 +235,17 @@ public:
     UPROPERTY()
     UGameActionSequence* GameActionSequence = nullptr;
 
+	// 开启后序列存放在单独的资源包中，仅在相邻片段激活时异步加载，内存紧张时可被卸载
+	UPROPERTY(EditAnywhere, Category = "配置", meta = (DisplayName = "延迟加载序列"))
+	uint8 bLazyLoadSequence : 1;
+	UPROPERTY()
+	TSoftObjectPtr<UGameActionSequence> LazyGameActionSequence;
+	UGameActionSequence* GetGameActionSequence() const;
+
+	void PostInitProperties() override;
+	void BeginDestroy() override;
+	void PrefetchResources() override;
+
 	UPROPERTY(EditAnywhere, Category = "配置", meta = (DisplayName = "播放至结尾时行为"))
 	EGameActionPlayerEndAction PlayEndAction = EGameActionPlayerEndAction::Stop;
 
@@ -160,6 +264,10 @@ public:
 protected:
 	UFUNCTION()
 	void OnSequenceFinished();
+
+	TSharedPtr<struct FStreamableHandle> LazySequenceHandle;
+	FDelegateHandle MemoryTrimHandle;
+	void WhenMemoryTrim();
 	// 功能函数
 public:
 	UFUNCTION(BlueprintCallable, Category = "游戏行为")
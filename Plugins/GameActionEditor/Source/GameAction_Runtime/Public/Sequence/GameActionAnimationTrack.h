@@ -91,13 +91,17 @@ struct GAMEACTION_RUNTIME_API FGameActionAnimationSectionTemplate : public FMovi
 	GENERATED_BODY()
 public:
 	FGameActionAnimationSectionTemplate() = default;
-	FGameActionAnimationSectionTemplate(const class UGameActionAnimationSection& Section);
+	FGameActionAnimationSectionTemplate(const class UGameActionAnimationSection& Section, int32 InSectionIndex);
 
 	UScriptStruct& GetScriptStructImpl() const override { return *StaticStruct(); }
 	void Evaluate(const FMovieSceneEvaluationOperand& Operand, const FMovieSceneContext& Context, const FPersistentEvaluationData& PersistentData, FMovieSceneExecutionTokens& ExecutionTokens) const override;
 
 	UPROPERTY()
 	FGameActionAnimationSectionTemplateParameters Params;
+
+	// 编译时分配的Section编号，执行器按编号直接索引蒙太奇实例数据
+	UPROPERTY()
+	int32 SectionIndex = 0;
 };
 
 UCLASS()
@@ -143,6 +147,7 @@ public:
 	UMovieSceneSection* CreateNewSection() override;
 	FMovieSceneTrackRowSegmentBlenderPtr GetRowSegmentBlender() const override;
 	FMovieSceneEvalTemplatePtr CreateTemplateForSection(const UMovieSceneSection& InSection) const override;
+	int32 GetCompiledSectionIndex(const UMovieSceneSection& InSection) const;
 
 #if WITH_EDITOR
 	static UAnimMontage* CreateMontage(UObject* Outer, UAnimSequenceBase* AnimSequence);
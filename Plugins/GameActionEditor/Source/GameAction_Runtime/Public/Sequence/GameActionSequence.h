@@ -21,6 +21,12 @@ public:
 	FName OwnerPropertyName;
 	UPROPERTY()
 	FString PathToSubobject;
+
+	// 编译期预解析的结果，运行时避免按名字查找属性和解析字符串路径
+	UPROPERTY()
+	TFieldPath<FObjectProperty> OwnerProperty;
+	UPROPERTY()
+	TArray<FName> SubobjectNames;
 };
 
 UCLASS()
@@ -42,6 +48,11 @@ public:
 	bool CanRebindPossessable(const FMovieScenePossessable& InPossessable) const override { return !InPossessable.GetParent().IsValid(); }
 	void PreSave(const ITargetPlatform* TargetPlatform) override;
 
+#if WITH_EDITOR
+	// 根据GameAction类预先解析绑定的属性与子对象路径
+	void CompileBindings(UClass* InstanceClass);
+#endif
+
 #if WITH_EDITORONLY_DATA
 	FGuid SetOwnerCharacter(const TSubclassOf<ACharacter>& OwnerType);
 	FGuid AddPossessableActor(const FName& Name, const TSubclassOf<AActor>& ActorType);
@@ -59,4 +70,11 @@ public:
 	TMap<FGuid, FName> PossessableActors;
 	UPROPERTY()
 	TMap<FGuid, FGameActionSequenceSubobjectBinding> BindingSubobjects;
+
+	UPROPERTY()
+	TMap<FGuid, TFieldPath<FObjectProperty>> CompiledPossessableProperties;
+private:
+	FObjectProperty* FindBindingProperty(UClass* InstanceClass, const TFieldPath<FObjectProperty>* CompiledProperty, const FName& PropertyName) const;
+	static UObject* FindSubobject(AActor* OwnerActor, const FGameActionSequenceSubobjectBinding& SubobjectBinding);
+	static void BuildSubobjectNames(FGameActionSequenceSubobjectBinding& SubobjectBinding);
 };
@@ -40,6 +40,11 @@ public:
 	uint8 bDestroyWhenAborted : 1;
 	UPROPERTY(EditAnywhere, Category = "生成器", meta = (DisplayName = "销毁延迟时间", EditCondition = "bAsReference == false || Ownership == EGameActionSpawnOwnership::Sequence"))
 	float DestroyDelayTime = 0.f;
+
+	// 为引用时由蓝图编译预先解析的引用属性，生成时不再按名字查找
+	UPROPERTY()
+	TFieldPath<FObjectProperty> ReferenceProperty;
+	AActor** GetReferenceSlot(UGameActionInstanceBase* GameActionInstance, const FName& TemplateName) const;
 };
 
 UCLASS()
@@ -32,6 +32,8 @@ class GAMEACTION_RUNTIME_API FGameActionSpawnRegister : public FMovieSceneSpawnR
 {
 public:
 	FGameActionSpawnRegister();
+
+	const TMap<TWeakObjectPtr<AActor>, const UGameActionSequenceSpawnerSettingsBase*>& GetSpawnOwnershipMap() const { return SpawnOwnershipMap; }
 protected:
 	/** ~ FMovieSceneSpawnRegister interface */
 	UObject* SpawnObject(FMovieSceneSpawnable& Spawnable, FMovieSceneSequenceIDRef TemplateID, IMovieScenePlayer& Player) override;
@@ -51,6 +53,8 @@ public:
 	void Initialize(UGameActionInstanceBase* InGameAction, UGameActionSequence* InSequence, float InPlayRate, EGameActionPlayerEndAction EndAction);
 	void SetFrameRange(int32 NewStartTime, int32 Duration);
 	void Play() { PlayInternal(); }
+	// 从序列的指定时间开始播放，之前的部分只求值该时间的最终状态，不触发帧事件，已结束的生成物不会生成
+	void PlayFromSeconds(float TimeInSeconds);
 	void Stop() { StopInternal(0); }
 	void StopAtCurrentTime() { StopInternal(PlayPosition.GetCurrentPosition()); }
 	void JumpToSeconds(float TimeInSeconds) { JumpToFrame(TimeInSeconds * PlayPosition.GetInputRate()); }
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <Containers/Queue.h>
+#include <HAL/CriticalSection.h>
+#include <Templates/Atomic.h>
+
+class UGameActionInstanceBase;
+class UGameActionSegmentBase;
+
+#if WITH_EDITOR
+/**
+ * 行为片段激活状态变化的调试事件，由运行时发布，编辑器调试器消费
+ */
+struct FGameActionDebugEvent
+{
+	enum class EType : uint8
+	{
+		Actived,
+		Deactived,
+		Aborted
+	};
+	EType Type = EType::Actived;
+	TWeakObjectPtr<UGameActionInstanceBase> Instance;
+	TWeakObjectPtr<UGameActionSegmentBase> Segment;
+	// 事件发生时所在世界的时间
+	float WorldTime = 0.f;
+};
+
+/**
+ * 调试事件的监听者，每个监听者持有独立的无锁队列，只接收正在调试的实例的事件
+ * 没有调试中的监听者时发布事件只有一次原子读取，监听者列表的注册、注销与遍历由锁保护
+ */
+class GAMEACTION_RUNTIME_API FGameActionDebugEventListener
+{
+public:
+	FGameActionDebugEventListener();
+	~FGameActionDebugEventListener();
+
+	bool Dequeue(FGameActionDebugEvent& OutEvent) { return EventQueue.Dequeue(OutEvent); }
+	// 为空时不接收任何事件
+	void SetDebugInstance(UGameActionInstanceBase* Instance);
+
+	static void Publish(FGameActionDebugEvent::EType Type, UGameActionSegmentBase* Segment);
+private:
+	TQueue<FGameActionDebugEvent, EQueueMode::Mpsc> EventQueue;
+	TWeakObjectPtr<UGameActionInstanceBase> DebugInstance;
+
+	static TArray<FGameActionDebugEventListener*> Listeners;
+	static FCriticalSection ListenersCriticalSection;
+	// 设置了调试实例的监听者数量
+	static TAtomic<int32> DebuggingListenerNum;
+};
+#endif
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/**
+ * 统计GameAction相关对象的数量与内存占用
+ * 控制台命令：GameAction.MemReport [-csv] [-templates]
+ */
+struct GAMEACTION_RUNTIME_API FGameActionMemReport
+{
+	struct FClassStat
+	{
+		int32 Count = 0;
+		SIZE_T ExclusiveBytes = 0;
+		SIZE_T InclusiveBytes = 0;
+	};
+
+	struct FCategoryStat
+	{
+		FString Category;
+		FClassStat Total;
+		TMap<FString, FClassStat> ClassStats;
+	};
+	TArray<FCategoryStat> Categories;
+
+	int32 EvaluationTemplateCount = 0;
+	SIZE_T EvaluationTemplateBytes = 0;
+
+	// World为空时统计所有世界中的对象，bIncludeTemplates为真时包含类默认对象与模板
+	void Gather(const UWorld* World, bool bIncludeTemplates);
+	void Print(FOutputDevice& Ar) const;
+	bool SaveCsv(const FString& FilePath) const;
+
+	static FString MakeDefaultCsvPath();
+};
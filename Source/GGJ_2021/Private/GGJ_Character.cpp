@@ -5,6 +5,11 @@
 #include <DrawDebugHelpers.h>
 #include <GameFramework/CharacterMovementComponent.h>
 #include <Components/CapsuleComponent.h>
+#include <EngineUtils.h>
+#include <Net/UnrealNetwork.h>
+
+#include "SmileDropletSimulation.h"
+#include "SplitSmileBodyMovementComponent.h"
 
 // Sets default values
 AGGJ_Character::AGGJ_Character()
@@ -13,183 +18,801 @@ AGGJ_Character::AGGJ_Character()
 }
 
 ASplitSmileBody::ASplitSmileBody()
+	: bIsBodyActived(true)
 {
 	PrimaryActorTick.bCanEverTick = true;
+
+	MovementComponent = CreateDefaultSubobject<USplitSmileBodyMovementComponent>(TEXT("MovementComponent"));
 }
 
-void ASplitSmileBody::Tick(float DeltaTime)
+FVector ASplitSmileBody::GetVelocity() const
 {
-	Super::Tick(DeltaTime);
+	return MovementComponent->Velocity;
+}
 
-	Velocity.Y = 0.f;
-	
-	const FVector PreLocation = GetActorLocation();
+void ASplitSmileBody::SetVelocity(const FVector& NewVelocity)
+{
+	MovementComponent->Velocity = NewVelocity;
+	if (MovementComponent->IsSleeping() && NewVelocity.SizeSquared() > FMath::Square(MovementComponent->SleepVelocityThreshold))
+	{
+		MovementComponent->WakeUp();
+	}
+}
 
-	const float GravityScale = (BodyScale - 0.2f);
-	Velocity += FVector(0.f, 0.f, -4000.f * GravityScale) * DeltaTime;
+void ASplitSmileBody::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
 
-	FHitResult HitResult;
-	AddActorWorldOffset(Velocity * DeltaTime, true, &HitResult);
-	if (HitResult.bBlockingHit)
+	if (const UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(GetRootComponent()))
 	{
-		const FVector BlockLocation = GetActorLocation();
-		const FVector VelocityDirection = Velocity.GetSafeNormal();
-		const FVector PlaneLocation = FMath::LinePlaneIntersection(BlockLocation + HitResult.ImpactNormal, BlockLocation + VelocityDirection * 100.f, BlockLocation, HitResult.ImpactNormal);
-		const FVector AdjustDirection = (PlaneLocation - BlockLocation).GetSafeNormal();
+		DefaultCollisionProfileName = Root->GetCollisionProfileName();
+	}
+}
 
-		const FVector AdjustVelocity = AdjustDirection * ((1.f - HitResult.Time) * Velocity.Size()) * (1.f - GravityScale);
-		AddActorWorldOffset(AdjustVelocity * DeltaTime, true);
+void ASplitSmileBody::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
 
-		GetRootComponent()->AttachToComponent(HitResult.Component.Get(), FAttachmentTransformRules::KeepWorldTransform);
+	// 只处理激活状态下被外部销毁的情况，正常合体走对象池
+	if (bIsBodyActived)
+	{
+		if (ASmile* Slime = Cast<ASmile>(GetOwner()))
+		{
+			Slime->RemoveSplitBody(this);
+		}
 	}
-	else
+}
+
+void ASplitSmileBody::ActivateBody(const FVector& Location, const FRotator& Rotation, float InBodyScale, const FVector& InVelocity)
+{
+	bIsBodyActived = true;
+	BodyScale = InBodyScale;
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorScale3D(FVector(BodyScale));
+	if (UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(GetRootComponent()))
 	{
-		GetRootComponent()->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		Root->SetCollisionProfileName(DefaultCollisionProfileName);
 	}
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	MovementComponent->ResetMovementState();
+	MovementComponent->Activate(true);
+	SetVelocity(InVelocity);
+	ReceiveActivateBody();
+}
 
-	Velocity = (GetActorLocation() - PreLocation) / DeltaTime;
+void ASplitSmileBody::DeactivateBody()
+{
+	bIsBodyActived = false;
+	MovementComponent->Velocity = FVector::ZeroVector;
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	MovementComponent->Deactivate();
+	NetBodyId = INDEX_NONE;
+	NetPredictionKey = 0;
+	ReceiveDeactivateBody();
 }
 
-void ASplitSmileBody::EndPlay(const EEndPlayReason::Type EndPlayReason)
+void FSmileSplitBodyStates::Add(const FVector& Location, const FVector& Velocity, float Scale, float Radius, float SplitTime)
+{
+	Locations.Add(Location);
+	Velocities.Add(Velocity);
+	Scales.Add(Scale);
+	Radii.Add(Radius);
+	SplitTimes.Add(SplitTime);
+	CanCombines.Add(false);
+}
+
+void FSmileSplitBodyStates::RemoveAtSwap(int32 Index)
+{
+	Locations.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Scales.RemoveAtSwap(Index, 1, false);
+	Radii.RemoveAtSwap(Index, 1, false);
+	SplitTimes.RemoveAtSwap(Index, 1, false);
+	CanCombines.RemoveAtSwap(Index, 1, false);
+}
+
+void FSmileSplitBodyStates::Empty()
+{
+	Locations.Empty();
+	Velocities.Empty();
+	Scales.Empty();
+	Radii.Empty();
+	SplitTimes.Empty();
+	CanCombines.Empty();
+}
+
+bool FSmileSplitBodyNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// 休眠的分裂体速度为零，只用一个标记位代替速度
+	enum EFlags : uint8
+	{
+		HasVelocity = 1 << 0,
+	};
+
+	uint8 Flags = Ar.IsSaving() && Velocity.IsNearlyZero(1.f) == false ? HasVelocity : 0;
+	Ar << BodyId;
+	Ar << PredictionKey;
+	Ar << Flags;
+
+	bOutSuccess = SerializePackedVector<10, 20>(Offset, Ar);
+	if (Flags & HasVelocity)
+	{
+		bOutSuccess &= SerializePackedVector<1, 16>(Velocity, Ar);
+	}
+	else if (Ar.IsLoading())
+	{
+		Velocity = FVector::ZeroVector;
+	}
+
+	// 体积精度为1/1024
+	uint16 QuantizedScale = Ar.IsSaving() ? FMath::Clamp(FMath::RoundToInt(Scale * 1024.f), 0, (int32)MAX_uint16) : 0;
+	Ar << QuantizedScale;
+	if (Ar.IsLoading())
+	{
+		Scale = QuantizedScale / 1024.f;
+	}
+	return true;
+}
+
+void FSmileSplitBodyNetState::PreReplicatedRemove(const FSmileSplitBodyNetStates& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->WhenSplitBodyNetStateRemoved(*this);
+	}
+}
+
+void FSmileSplitBodyNetState::PostReplicatedAdd(const FSmileSplitBodyNetStates& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->WhenSplitBodyNetStateAdded(*this);
+	}
+}
+
+void FSmileSplitBodyNetState::PostReplicatedChange(const FSmileSplitBodyNetStates& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->WhenSplitBodyNetStateChanged(*this);
+	}
+}
+
+FSmileSplitBodyNetState* FSmileSplitBodyNetStates::FindByBodyId(int32 BodyId)
+{
+	return Items.FindByPredicate([&](const FSmileSplitBodyNetState& E) { return E.BodyId == BodyId; });
+}
+
+ASmile::ASmile()
+	: bIsInvokeCombine(false)
+	, bPrewarmSplitBodyPool(true)
+{
+	SplitBodyNetStates.Owner = this;
+}
+
+void ASmile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASmile, BodyScale);
+	DOREPLIFETIME_CONDITION(ASmile, bIsInvokeCombine, COND_SkipOwner);
+	DOREPLIFETIME(ASmile, SplitBodyNetStates);
+}
+
+void ASmile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (bPrewarmSplitBodyPool)
+	{
+		TArray<ASplitSmileBody*, TInlineAllocator<4>> Bodies;
+		for (int32 Idx = SplitBodyPool.Num(); Idx < MaxSplitBodyNum; ++Idx)
+		{
+			if (ASplitSmileBody* Body = AcquireSplitBody())
+			{
+				Bodies.Add(Body);
+			}
+		}
+		for (ASplitSmileBody* Body : Bodies)
+		{
+			ReleaseSplitBody(Body);
+		}
+	}
+}
+
+void ASmile::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
-	if (ASmile* Slime = Cast<ASmile>(GetOwner()))
+	// 激活中的分裂体销毁时会从列表中移除自己，先移出列表再销毁
+	const TArray<ASplitSmileBody*> ActivedBodies = MoveTemp(SplitBodies);
+	SplitBodies.Reset();
+	BodyStates.Empty();
+	SplitBody = nullptr;
+	for (ASplitSmileBody* Body : ActivedBodies)
 	{
-		Slime->BodyScale += BodyScale;
-		Slime->SetActorScale3D(FVector(Slime->BodyScale));
+		if (IsValid(Body))
+		{
+			Body->Destroy();
+		}
+	}
 
-		Slime->GetCapsuleComponent()->SetCollisionProfileName(TEXT("Pawn"));
+	for (ASplitSmileBody* Body : SplitBodyPool)
+	{
+		if (IsValid(Body))
+		{
+			Body->Destroy();
+		}
 	}
+	SplitBodyPool.Empty();
 }
 
 void ASmile::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	if (SplitBody)
+	const int32 BodyNum = SplitBodies.Num();
+	if (BodyNum == 0)
 	{
-		const FVector BodyToSmile = GetActorLocation() - SplitBody->GetActorLocation();
-		const FVector BodyToSmileDirection = BodyToSmile.GetSafeNormal();
-		const FVector SmileToBodySmileDirection = -BodyToSmileDirection;
-		UCharacterMovementComponent* MovementComponent = GetCharacterMovement();
+		return;
+	}
+
+	for (int32 Idx = 0; Idx < BodyNum; ++Idx)
+	{
+		const ASplitSmileBody* Body = SplitBodies[Idx];
+		BodyStates.Locations[Idx] = Body->GetActorLocation();
+		BodyStates.Velocities[Idx] = Body->GetVelocity();
+	}
+
+	UCharacterMovementComponent* MovementComponent = GetCharacterMovement();
+	const FVector SmileLocation = GetActorLocation();
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	const float SmileRadius = GetCapsuleComponent()->GetScaledCapsuleRadius();
+	const float SlimeAttraction = SlimeAttractionCurve->GetFloatValue(BodyScale);
 
-		const float AttractionScale = FMath::Clamp(SplitBody->GetGameTimeSinceCreation() * 2.f, 0.f, 1.f);
-		const FVector SlimeVelocity = SlimeAttractionCurve->GetFloatValue(BodyScale) * SmileToBodySmileDirection * AttractionScale;
+	FVector SlimeImpulse = FVector::ZeroVector;
+	int32 NearestBodyIndex = INDEX_NONE;
+	float NearestDistanceSquared = TNumericLimits<float>::Max();
+	TArray<ASplitSmileBody*, TInlineAllocator<4>> CombineBodies;
+	for (int32 Idx = 0; Idx < BodyNum; ++Idx)
+	{
+		const FVector BodyToSmile = SmileLocation - BodyStates.Locations[Idx];
+		const float DistanceSquared = BodyToSmile.SizeSquared();
+		const FVector BodyToSmileDirection = BodyToSmile.GetSafeNormal();
+		const float AttractionScale = FMath::Clamp((WorldTime - BodyStates.SplitTimes[Idx]) * 2.f, 0.f, 1.f);
+		const FVector BodyVelocity = BodyAttractionCurve->GetFloatValue(BodyStates.Scales[Idx]) * BodyToSmileDirection * AttractionScale;
 
-		const FVector BodyVelocity = BodyAttractionCurve->GetFloatValue(SplitBody->BodyScale) * BodyToSmileDirection * AttractionScale;
-		
 		if (bIsInvokeCombine)
 		{
-			if (BodyScale < 0.5f)
+			if (BodyScale >= 0.5f)
 			{
-				MovementComponent->ClearAccumulatedForces();
-				MovementComponent->AddImpulse(SlimeVelocity * DeltaTime * 100.f, true);
-			}
-			else
-			{
-				SplitBody->Velocity = BodyVelocity * DeltaTime * 100.f;
+				BodyStates.Velocities[Idx] = BodyVelocity * DeltaTime * 100.f;
 			}
 		}
 		else
 		{
-			MovementComponent->AddImpulse(SlimeVelocity * DeltaTime, true);
+			SlimeImpulse -= SlimeAttraction * BodyToSmileDirection * AttractionScale;
+			BodyStates.Velocities[Idx] += BodyVelocity * DeltaTime;
+		}
+
+		if (DistanceSquared < NearestDistanceSquared)
+		{
+			NearestDistanceSquared = DistanceSquared;
+			NearestBodyIndex = Idx;
+		}
 
-			SplitBody->Velocity += BodyVelocity * DeltaTime;
+		// 用距离检测代替重叠查询，分裂体离开过本体后才能合体
+		const float CombineDistance = SmileRadius + BodyStates.Radii[Idx] + CombineDistanceTolerance;
+		if (DistanceSquared > FMath::Square(CombineDistance))
+		{
+			BodyStates.CanCombines[Idx] = true;
+		}
+		else if (BodyStates.CanCombines[Idx] && WorldTime - BodyStates.SplitTimes[Idx] > 0.1f)
+		{
+			CombineBodies.Add(SplitBodies[Idx]);
 		}
 	}
 
-	TArray<AActor*> OverlapBodies;
-	GetOverlappingActors(OverlapBodies, ASplitSmileBody::StaticClass());
-	for (AActor* OverlapBody : OverlapBodies)
+	if (bIsInvokeCombine)
 	{
-		if (OverlapBody == SplitBody)
+		// 本体较小时冲向最近的分裂体
+		if (BodyScale < 0.5f)
 		{
-			TryCombine();
+			const FVector SmileToBodyDirection = (BodyStates.Locations[NearestBodyIndex] - SmileLocation).GetSafeNormal();
+			const float AttractionScale = FMath::Clamp((WorldTime - BodyStates.SplitTimes[NearestBodyIndex]) * 2.f, 0.f, 1.f);
+			MovementComponent->ClearAccumulatedForces();
+			MovementComponent->AddImpulse(SlimeAttraction * SmileToBodyDirection * AttractionScale * DeltaTime * 100.f, true);
+		}
+	}
+	else
+	{
+		MovementComponent->AddImpulse(SlimeImpulse * DeltaTime, true);
+	}
+
+	for (int32 Idx = 0; Idx < BodyNum; ++Idx)
+	{
+		SplitBodies[Idx]->SetVelocity(BodyStates.Velocities[Idx]);
+	}
+
+	// 合体只由服务器判定，客户端等待广播或同步状态的移除
+	if (HasAuthority())
+	{
+		for (ASplitSmileBody* Body : CombineBodies)
+		{
+			TryCombine(Body);
+		}
+
+		UpdateSplitBodyNetStates();
+		if (PendingCombineBodyIds.Num() > 0)
+		{
+			CombineSplitBodiesNetMulticast(PendingCombineBodyIds);
+			PendingCombineBodyIds.Reset();
+		}
+	}
+	else if (GetLocalRole() == ROLE_AutonomousProxy)
+	{
+		// 服务器拒绝了预测的分裂，回收分裂体并还原体积
+		for (int32 Idx = SplitBodies.Num() - 1; Idx >= 0; --Idx)
+		{
+			ASplitSmileBody* Body = SplitBodies[Idx];
+			if (Body->NetBodyId == INDEX_NONE && WorldTime - BodyStates.SplitTimes[Idx] > SplitPredictionTimeout)
+			{
+				RemoveSplitBody(Body, true);
+				ReleaseSplitBody(Body);
+			}
 		}
 	}
 }
 
-void ASmile::TryCombine()
+void ASmile::TryCombine(ASplitSmileBody* Body)
 {
-	if (SplitBody->bCanCombine && SplitBody->GetGameTimeSinceCreation() > 0.1f)
+	UCharacterMovementComponent* MovementComponent = GetCharacterMovement();
+	if (bIsInvokeCombine == false)
 	{
-		UCharacterMovementComponent* MovementComponent = GetCharacterMovement();
-		if (bIsInvokeCombine == false)
+		const FVector AdjustForce = Body->GetVelocity() * Body->BodyScale - MovementComponent->Velocity * BodyScale;
+		MovementComponent->AddImpulse(AdjustForce);
+	}
+	else
+	{
+		MovementComponent->Velocity = FVector::ZeroVector;
+	}
+
+	if (HasAuthority() && Body->NetBodyId != INDEX_NONE)
+	{
+		PendingCombineBodyIds.Add(Body->NetBodyId);
+	}
+	RemoveSplitBody(Body, HasAuthority());
+	ReleaseSplitBody(Body);
+}
+
+void ASmile::RemoveSplitBody(ASplitSmileBody* Body, bool bMergeScale)
+{
+	const int32 BodyIndex = SplitBodies.Find(Body);
+	if (BodyIndex == INDEX_NONE)
+	{
+		return;
+	}
+	SplitBodies.RemoveAtSwap(BodyIndex, 1, false);
+	BodyStates.RemoveAtSwap(BodyIndex);
+
+	if (HasAuthority() && Body->NetBodyId != INDEX_NONE)
+	{
+		const int32 NetStateIndex = SplitBodyNetStates.Items.IndexOfByPredicate([&](const FSmileSplitBodyNetState& E) { return E.BodyId == Body->NetBodyId; });
+		if (NetStateIndex != INDEX_NONE)
 		{
-			const FVector AdjustForce = SplitBody->Velocity * SplitBody->BodyScale - MovementComponent->Velocity * BodyScale;
-			MovementComponent->AddImpulse(AdjustForce);
+			SplitBodyNetStates.Items.RemoveAtSwap(NetStateIndex, 1, false);
+			SplitBodyNetStates.MarkArrayDirty();
 		}
-		else
+	}
+
+	if (bMergeScale)
+	{
+		BodyScale += Body->BodyScale;
+		SetActorScale3D(FVector(BodyScale));
+	}
+
+	if (SplitBodies.Num() == 0)
+	{
+		SplitBody = nullptr;
+		bIsInvokeCombine = false;
+		GetCapsuleComponent()->SetCollisionProfileName(TEXT("Pawn"));
+	}
+	else if (SplitBody == Body)
+	{
+		SplitBody = SplitBodies.Last();
+	}
+}
+
+void ASmile::Split(const FVector& Velocity, float LostScale)
+{
+	switch (GetLocalRole())
+	{
+	case ROLE_Authority:
+		if (ASplitSmileBody* Body = SplitImpl(Velocity, LostScale))
+		{
+			AddSplitBodyNetState(Body, 0);
+		}
+		break;
+	case ROLE_AutonomousProxy:
+		// 主控端先行分裂，服务器确认后通过预测编号绑定
+		if (ASplitSmileBody* Body = SplitImpl(Velocity, LostScale))
 		{
-			bIsInvokeCombine = false;
-			MovementComponent->Velocity = FVector::ZeroVector;
+			NextPredictionKey = NextPredictionKey == MAX_uint8 ? 1 : NextPredictionKey + 1;
+			Body->NetPredictionKey = NextPredictionKey;
+			SplitToServer(Velocity, LostScale, NextPredictionKey);
 		}
+		break;
+	default:
+		break;
+	}
+}
 
-		SplitBody->Destroy();
-		SplitBody = nullptr;
+void ASmile::SplitToServer_Implementation(const FVector_NetQuantize10& Velocity, float LostScale, uint8 PredictionKey)
+{
+	if (LostScale <= 0.f || LostScale >= BodyScale)
+	{
+		return;
+	}
+	if (ASplitSmileBody* Body = SplitImpl(Velocity, LostScale))
+	{
+		AddSplitBodyNetState(Body, PredictionKey);
 	}
 }
 
-void ASmile::NotifyActorBeginOverlap(AActor* OtherActor)
+ASplitSmileBody* ASmile::SplitImpl(const FVector& Velocity, float LostScale)
 {
-	if (SplitBody == OtherActor)
+	if (SplitBodies.Num() >= MaxSplitBodyNum)
+	{
+		return nullptr;
+	}
+
+	ASplitSmileBody* Body = AcquireSplitBody();
+	if (Body == nullptr)
 	{
-		TryCombine();
+		return nullptr;
 	}
+
+	BodyScale -= LostScale;
+	SetActorScale3D(FVector(BodyScale));
+
+	Body->ActivateBody(GetActorLocation() + Velocity.GetSafeNormal() * 50.f, Velocity.Rotation(), LostScale, Velocity);
+	AddSplitBody(Body, Velocity);
+	return Body;
 }
 
-void ASmile::NotifyActorEndOverlap(AActor* OtherActor)
+void ASmile::AddSplitBody(ASplitSmileBody* Body, const FVector& Velocity)
 {
-	if (SplitBody == OtherActor)
+	SplitBody = Body;
+	SplitBodies.Add(Body);
+	BodyStates.Add(Body->GetActorLocation(), Velocity, Body->BodyScale, Body->GetRootComponent()->Bounds.SphereRadius, GetWorld()->GetTimeSeconds());
+}
+
+void ASmile::Shatter(const FVector& Velocity, float LostScale, int32 DropletNum, float SpreadAngle)
+{
+	if (DropletSimulationClass == nullptr || DropletNum <= 0 || LostScale <= 0.f || LostScale >= BodyScale)
 	{
-		SplitBody->bCanCombine = true;
+		return;
+	}
+
+	const int32 RandomSeed = FMath::Rand();
+	switch (GetLocalRole())
+	{
+	case ROLE_Authority:
+		ShatterNetMulticast(Velocity, LostScale, DropletNum, SpreadAngle, RandomSeed);
+		break;
+	case ROLE_AutonomousProxy:
+		// 主控端先行生成碎片，体积以服务器同步为准
+		ShatterImpl(Velocity, LostScale, DropletNum, SpreadAngle, RandomSeed);
+		ShatterToServer(Velocity, LostScale, DropletNum, SpreadAngle, RandomSeed);
+		break;
+	default:
+		break;
 	}
 }
 
-void ASmile::Split(const FVector& Velocity, float LostScale)
+void ASmile::ShatterToServer_Implementation(const FVector_NetQuantize10& Velocity, float LostScale, int32 DropletNum, float SpreadAngle, int32 RandomSeed)
+{
+	if (DropletNum <= 0 || LostScale <= 0.f || LostScale >= BodyScale)
+	{
+		return;
+	}
+	ShatterNetMulticast(Velocity, LostScale, DropletNum, SpreadAngle, RandomSeed);
+}
+
+void ASmile::ShatterNetMulticast_Implementation(const FVector_NetQuantize10& Velocity, float LostScale, int32 DropletNum, float SpreadAngle, int32 RandomSeed)
 {
-	if (IsValid(SplitBody) == false)
+	// 主控端已经先行生成
+	if (GetLocalRole() == ROLE_AutonomousProxy)
 	{
-		BodyScale -= LostScale;
+		return;
+	}
+
+	const int32 EmittedNum = ShatterImpl(Velocity, LostScale, DropletNum, SpreadAngle, RandomSeed);
+	if (HasAuthority())
+	{
+		BodyScale -= LostScale / DropletNum * EmittedNum;
 		SetActorScale3D(FVector(BodyScale));
+	}
+}
+
+int32 ASmile::ShatterImpl(const FVector& Velocity, float LostScale, int32 DropletNum, float SpreadAngle, int32 RandomSeed)
+{
+	if (DropletSimulationClass == nullptr || DropletNum <= 0)
+	{
+		return 0;
+	}
 
-		FActorSpawnParameters ActorSpawnParameters;
-		ActorSpawnParameters.Owner = this;
-		ActorSpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		SplitBody = GetWorld()->SpawnActor<ASplitSmileBody>(SplitBodyClass, GetActorLocation() + Velocity.GetSafeNormal() * 50.f, Velocity.Rotation(), ActorSpawnParameters);
+	UWorld* World = GetWorld();
+	ASmileDropletSimulation* DropletSimulation = nullptr;
+	for (TActorIterator<ASmileDropletSimulation> It(World, DropletSimulationClass); It; ++It)
+	{
+		DropletSimulation = *It;
+		break;
+	}
+	if (DropletSimulation == nullptr)
+	{
+		DropletSimulation = World->SpawnActor<ASmileDropletSimulation>(DropletSimulationClass);
+		if (DropletSimulation == nullptr)
+		{
+			return 0;
+		}
+	}
+
+	// 碎片只在XZ平面内扩散，超出碎片上限的部分不会离开本体
+	const FRandomStream RandomStream(RandomSeed);
+	const float DropletScale = LostScale / DropletNum;
+	const FVector Location = GetActorLocation();
+	const float Speed = Velocity.Size();
+	const FVector Direction = Speed > KINDA_SMALL_NUMBER ? Velocity / Speed : FVector::UpVector;
+	int32 EmittedNum = 0;
+	for (int32 Idx = 0; Idx < DropletNum; ++Idx)
+	{
+		const FVector DropletDirection = Direction.RotateAngleAxis(RandomStream.FRandRange(-SpreadAngle, SpreadAngle), FVector::RightVector);
+		const FVector DropletVelocity = DropletDirection * Speed * RandomStream.FRandRange(0.6f, 1.f);
+		if (DropletSimulation->EmitDroplet(this, Location + DropletDirection * 50.f, DropletVelocity, DropletScale))
+		{
+			EmittedNum += 1;
+		}
+	}
+	return EmittedNum;
+}
 
-		SplitBody->BodyScale = LostScale;
-		SplitBody->SetActorScale3D(FVector(SplitBody->BodyScale));
-		SplitBody->Velocity = Velocity;
+void ASmile::AbsorbScale(float Scale)
+{
+	if (HasAuthority())
+	{
+		BodyScale += Scale;
+		SetActorScale3D(FVector(BodyScale));
 	}
 }
 
 void ASmile::Combine()
 {
-	if (SplitBody && bIsInvokeCombine == false)
+	if (SplitBodies.Num() > 0 && bIsInvokeCombine == false && GetLocalRole() != ROLE_SimulatedProxy)
 	{
+		if (GetLocalRole() == ROLE_AutonomousProxy)
+		{
+			CombineToServer();
+		}
 		bIsInvokeCombine = true;
+		StartCombine();
+	}
+}
 
-		if (BodyScale > 0.5f)
+void ASmile::CombineToServer_Implementation()
+{
+	Combine();
+}
+
+void ASmile::OnRep_IsInvokeCombine()
+{
+	if (bIsInvokeCombine && SplitBodies.Num() > 0)
+	{
+		StartCombine();
+	}
+}
+
+void ASmile::OnRep_BodyScale()
+{
+	SetActorScale3D(FVector(BodyScale));
+}
+
+void ASmile::StartCombine()
+{
+	if (BodyScale > 0.5f)
+	{
+		for (ASplitSmileBody* Body : SplitBodies)
 		{
-			const FVector BodyToSmile = GetActorLocation() - SplitBody->GetActorLocation();
+			const FVector BodyToSmile = GetActorLocation() - Body->GetActorLocation();
 			const FVector BodyToSmileDirection = BodyToSmile.GetSafeNormal();
 
-			SplitBody->Velocity = BodyToSmileDirection * 2000.f;
-			if (UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(SplitBody->GetRootComponent()))
+			Body->SetVelocity(BodyToSmileDirection * 2000.f);
+			if (UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(Body->GetRootComponent()))
 			{
 				Root->SetCollisionProfileName(TEXT("SplitBodyCombine"));
 			}
 		}
-		else
+	}
+	else
+	{
+		const ASplitSmileBody* NearestBody = SplitBodies[0];
+		for (const ASplitSmileBody* Body : SplitBodies)
 		{
-			const FVector SmileToBody = SplitBody->GetActorLocation() - GetActorLocation();
-			const FVector SmileToBodySmileDirection = SmileToBody.GetSafeNormal();
+			if (FVector::DistSquared(Body->GetActorLocation(), GetActorLocation()) < FVector::DistSquared(NearestBody->GetActorLocation(), GetActorLocation()))
+			{
+				NearestBody = Body;
+			}
+		}
+		const FVector SmileToBody = NearestBody->GetActorLocation() - GetActorLocation();
+		const FVector SmileToBodySmileDirection = SmileToBody.GetSafeNormal();
 
-			UCharacterMovementComponent* MovementComponent = GetCharacterMovement();
-			MovementComponent->AddImpulse(SmileToBodySmileDirection * 2000.f, true);
-			GetCapsuleComponent()->SetCollisionProfileName(TEXT("SmileCombine"));
+		UCharacterMovementComponent* MovementComponent = GetCharacterMovement();
+		MovementComponent->AddImpulse(SmileToBodySmileDirection * 2000.f, true);
+		GetCapsuleComponent()->SetCollisionProfileName(TEXT("SmileCombine"));
+	}
+}
+
+ASplitSmileBody* ASmile::FindSplitBodyByNetId(int32 BodyId) const
+{
+	ASplitSmileBody* const* Body = SplitBodies.FindByPredicate([&](const ASplitSmileBody* E) { return E->NetBodyId == BodyId; });
+	return Body ? *Body : nullptr;
+}
+
+void ASmile::AddSplitBodyNetState(ASplitSmileBody* Body, uint8 PredictionKey)
+{
+	// 同时存在的分裂体很少，顺延找到未使用的编号即可
+	while (FindSplitBodyByNetId(NextNetBodyId))
+	{
+		NextNetBodyId += 1;
+	}
+	Body->NetBodyId = NextNetBodyId;
+	NextNetBodyId += 1;
+
+	FSmileSplitBodyNetState& NetState = SplitBodyNetStates.Items.AddDefaulted_GetRef();
+	NetState.BodyId = Body->NetBodyId;
+	NetState.PredictionKey = PredictionKey;
+	NetState.Offset = Body->GetActorLocation() - GetActorLocation();
+	NetState.Velocity = Body->GetVelocity();
+	NetState.Scale = Body->BodyScale;
+	SplitBodyNetStates.MarkItemDirty(NetState);
+}
+
+void ASmile::UpdateSplitBodyNetStates()
+{
+	const FVector SmileLocation = GetActorLocation();
+	for (const ASplitSmileBody* Body : SplitBodies)
+	{
+		FSmileSplitBodyNetState* NetState = SplitBodyNetStates.FindByBodyId(Body->NetBodyId);
+		if (NetState == nullptr)
+		{
+			continue;
+		}
+
+		const FVector Offset = Body->GetActorLocation() - SmileLocation;
+		if (FVector::DistSquared(NetState->Offset, Offset) > FMath::Square(NetLocationTolerance) ||
+			FVector::DistSquared(NetState->Velocity, Body->GetVelocity()) > FMath::Square(NetVelocityTolerance) ||
+			NetState->Scale != Body->BodyScale)
+		{
+			NetState->Offset = Offset;
+			NetState->Velocity = Body->GetVelocity();
+			NetState->Scale = Body->BodyScale;
+			SplitBodyNetStates.MarkItemDirty(*NetState);
 		}
 	}
 }
+
+void ASmile::ApplySplitBodyNetState(ASplitSmileBody* Body, const FSmileSplitBodyNetState& NetState)
+{
+	if (Body->BodyScale != NetState.Scale)
+	{
+		Body->BodyScale = NetState.Scale;
+		Body->SetActorScale3D(FVector(NetState.Scale));
+	}
+
+	const FVector Error = GetActorLocation() + NetState.Offset - Body->GetActorLocation();
+	if (Error.SizeSquared() > FMath::Square(NetSnapDistance))
+	{
+		Body->SetActorLocation(Body->GetActorLocation() + Error, false, nullptr, ETeleportType::TeleportPhysics);
+		Body->SetVelocity(NetState.Velocity);
+	}
+	else
+	{
+		Body->SetVelocity(NetState.Velocity + Error * NetCorrectionStrength);
+	}
+}
+
+void ASmile::WhenSplitBodyNetStateAdded(const FSmileSplitBodyNetState& NetState)
+{
+	if (HasAuthority() || FindSplitBodyByNetId(NetState.BodyId))
+	{
+		return;
+	}
+
+	if (NetState.PredictionKey != 0)
+	{
+		ASplitSmileBody* const* PredictedBody = SplitBodies.FindByPredicate([&](const ASplitSmileBody* E) { return E->NetBodyId == INDEX_NONE && E->NetPredictionKey == NetState.PredictionKey; });
+		if (PredictedBody)
+		{
+			(*PredictedBody)->NetBodyId = NetState.BodyId;
+			(*PredictedBody)->NetPredictionKey = 0;
+			ApplySplitBodyNetState(*PredictedBody, NetState);
+			return;
+		}
+	}
+
+	ASplitSmileBody* Body = AcquireSplitBody();
+	if (Body == nullptr)
+	{
+		return;
+	}
+	Body->ActivateBody(GetActorLocation() + NetState.Offset, NetState.Velocity.Rotation(), NetState.Scale, NetState.Velocity);
+	Body->NetBodyId = NetState.BodyId;
+	AddSplitBody(Body, NetState.Velocity);
+}
+
+void ASmile::WhenSplitBodyNetStateChanged(const FSmileSplitBodyNetState& NetState)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+	if (ASplitSmileBody* Body = FindSplitBodyByNetId(NetState.BodyId))
+	{
+		ApplySplitBodyNetState(Body, NetState);
+	}
+}
+
+void ASmile::WhenSplitBodyNetStateRemoved(const FSmileSplitBodyNetState& NetState)
+{
+	// 合体广播丢失时由状态移除兜底
+	if (HasAuthority())
+	{
+		return;
+	}
+	if (ASplitSmileBody* Body = FindSplitBodyByNetId(NetState.BodyId))
+	{
+		TryCombine(Body);
+	}
+}
+
+void ASmile::CombineSplitBodiesNetMulticast_Implementation(const TArray<uint8>& BodyIds)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+	for (uint8 BodyId : BodyIds)
+	{
+		if (ASplitSmileBody* Body = FindSplitBodyByNetId(BodyId))
+		{
+			TryCombine(Body);
+		}
+	}
+}
+
+ASplitSmileBody* ASmile::AcquireSplitBody()
+{
+	while (SplitBodyPool.Num() > 0)
+	{
+		ASplitSmileBody* Body = SplitBodyPool.Pop(false);
+		if (IsValid(Body))
+		{
+			return Body;
+		}
+	}
+
+	FActorSpawnParameters ActorSpawnParameters;
+	ActorSpawnParameters.Owner = this;
+	ActorSpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<ASplitSmileBody>(SplitBodyClass, GetActorLocation(), FRotator::ZeroRotator, ActorSpawnParameters);
+}
+
+void ASmile::ReleaseSplitBody(ASplitSmileBody* Body)
+{
+	Body->DeactivateBody();
+	SplitBodyPool.Add(Body);
+}
@@ -0,0 +1,397 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SmileDropletSimulation.h"
+#include <Components/InstancedStaticMeshComponent.h>
+#include <Components/CapsuleComponent.h>
+#include <Curves/CurveFloat.h>
+#include <Engine/World.h>
+
+#include "GGJ_Character.h"
+
+namespace DropletUtils
+{
+	template<typename T>
+	void MoveLast(TArray<T>& Array, int32 Index, int32 LastIndex, const T& EmptyValue)
+	{
+		Array[Index] = Array[LastIndex];
+		Array[LastIndex] = EmptyValue;
+	}
+
+	FIntVector ToCell(const FVector& Position, float InvCellSize)
+	{
+		return FIntVector(FMath::FloorToInt(Position.X * InvCellSize), FMath::FloorToInt(Position.Y * InvCellSize), FMath::FloorToInt(Position.Z * InvCellSize));
+	}
+}
+
+int32 FSmileDropletStates::Add()
+{
+	const int32 Index = Num;
+	Num += 1;
+
+	const int32 PaddedNum = Align(Num, 4);
+	for (TArray<float>* Array : { &PositionX, &PositionY, &PositionZ, &VelocityX, &VelocityY, &VelocityZ, &Scales, &Attractions, &Ages, &TargetX, &TargetY, &TargetZ })
+	{
+		if (Array->Num() < PaddedNum)
+		{
+			Array->SetNumZeroed(PaddedNum, false);
+		}
+	}
+	OwnerIndices.Add(INDEX_NONE);
+	TraceHandles.AddDefaulted();
+	ContactPoints.AddZeroed();
+	ContactNormals.AddZeroed();
+	HasContacts.Add(false);
+	return Index;
+}
+
+void FSmileDropletStates::RemoveAtSwap(int32 Index)
+{
+	using namespace DropletUtils;
+
+	const int32 LastIndex = Num - 1;
+	for (TArray<float>* Array : { &PositionX, &PositionY, &PositionZ, &VelocityX, &VelocityY, &VelocityZ, &Scales, &Attractions, &Ages, &TargetX, &TargetY, &TargetZ })
+	{
+		MoveLast(*Array, Index, LastIndex, 0.f);
+	}
+	OwnerIndices.RemoveAtSwap(Index, 1, false);
+	TraceHandles.RemoveAtSwap(Index, 1, false);
+	ContactPoints.RemoveAtSwap(Index, 1, false);
+	ContactNormals.RemoveAtSwap(Index, 1, false);
+	HasContacts.RemoveAtSwap(Index, 1, false);
+	Num = LastIndex;
+}
+
+void FSmileDropletStates::SetPosition(int32 Index, const FVector& Position)
+{
+	PositionX[Index] = Position.X;
+	PositionY[Index] = Position.Y;
+	PositionZ[Index] = Position.Z;
+}
+
+void FSmileDropletStates::SetVelocity(int32 Index, const FVector& Velocity)
+{
+	VelocityX[Index] = Velocity.X;
+	VelocityY[Index] = Velocity.Y;
+	VelocityZ[Index] = Velocity.Z;
+}
+
+ASmileDropletSimulation::ASmileDropletSimulation()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	DropletMeshes = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("DropletMeshes"));
+	DropletMeshes->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	DropletMeshes->SetGenerateOverlapEvents(false);
+	SetRootComponent(DropletMeshes);
+}
+
+bool ASmileDropletSimulation::EmitDroplet(ASmile* SourceSmile, const FVector& Location, const FVector& Velocity, float Scale)
+{
+	if (States.Num >= MaxDropletNum)
+	{
+		return false;
+	}
+
+	const int32 Index = States.Add();
+	States.SetPosition(Index, Location);
+	States.SetVelocity(Index, FVector(Velocity.X, 0.f, Velocity.Z));
+	States.Scales[Index] = Scale;
+	States.Attractions[Index] = BodyAttractionCurve ? BodyAttractionCurve->GetFloatValue(Scale) : 0.f;
+
+	int32 OwnerIndex = Slimes.IndexOfByKey(SourceSmile);
+	if (OwnerIndex == INDEX_NONE && SourceSmile)
+	{
+		OwnerIndex = Slimes.Add(SourceSmile);
+	}
+	States.OwnerIndices[Index] = OwnerIndex;
+
+	DropletMeshes->AddInstance(FTransform(FQuat::Identity, Location, FVector(Scale)), true);
+	return true;
+}
+
+void ASmileDropletSimulation::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (States.Num == 0 || DeltaTime <= 0.f)
+	{
+		return;
+	}
+
+	ResolveTraceResults();
+	GatherTargets();
+	Integrate(DeltaTime);
+	ResolveContacts();
+	MergeDroplets();
+	SubmitTraces(DeltaTime);
+	UpdateInstances();
+}
+
+void ASmileDropletSimulation::ResolveTraceResults()
+{
+	const UWorld* World = GetWorld();
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		FTraceDatum TraceDatum;
+		if (World->QueryTraceData(States.TraceHandles[Idx], TraceDatum))
+		{
+			const FHitResult* Hit = TraceDatum.OutHits.FindByPredicate([](const FHitResult& E) { return E.bBlockingHit; });
+			States.HasContacts[Idx] = Hit != nullptr;
+			if (Hit)
+			{
+				States.ContactPoints[Idx] = Hit->ImpactPoint;
+				States.ContactNormals[Idx] = Hit->ImpactNormal;
+			}
+		}
+	}
+}
+
+void ASmileDropletSimulation::GatherTargets()
+{
+	TArray<FVector, TInlineAllocator<16>> SlimeLocations;
+	TArray<bool, TInlineAllocator<16>> SlimeValids;
+	for (const TWeakObjectPtr<ASmile>& Slime : Slimes)
+	{
+		SlimeValids.Add(Slime.IsValid());
+		SlimeLocations.Add(Slime.IsValid() ? Slime->GetActorLocation() : FVector::ZeroVector);
+	}
+
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		const int32 OwnerIndex = States.OwnerIndices[Idx];
+		if (OwnerIndex != INDEX_NONE && SlimeValids[OwnerIndex])
+		{
+			const FVector& Target = SlimeLocations[OwnerIndex];
+			States.TargetX[Idx] = Target.X;
+			States.TargetY[Idx] = Target.Y;
+			States.TargetZ[Idx] = Target.Z;
+		}
+		else
+		{
+			// 本体不存在时不受吸引
+			States.TargetX[Idx] = States.PositionX[Idx];
+			States.TargetY[Idx] = States.PositionY[Idx];
+			States.TargetZ[Idx] = States.PositionZ[Idx];
+		}
+	}
+}
+
+void ASmileDropletSimulation::Integrate(float DeltaTime)
+{
+	const VectorRegister VDeltaTime = VectorSetFloat1(DeltaTime);
+	const VectorRegister VGravity = VectorSetFloat1(-DropletGravity * DeltaTime);
+	const VectorRegister VZero = VectorZero();
+	const VectorRegister VOne = VectorOne();
+	const VectorRegister VTwo = VectorSetFloat1(2.f);
+	const VectorRegister VMinDistanceSquared = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+	const int32 PaddedNum = Align(States.Num, 4);
+	for (int32 Idx = 0; Idx < PaddedNum; Idx += 4)
+	{
+		VectorRegister PositionX = VectorLoad(&States.PositionX[Idx]);
+		VectorRegister PositionY = VectorLoad(&States.PositionY[Idx]);
+		VectorRegister PositionZ = VectorLoad(&States.PositionZ[Idx]);
+		VectorRegister VelocityX = VectorLoad(&States.VelocityX[Idx]);
+		VectorRegister VelocityZ = VectorLoad(&States.VelocityZ[Idx]);
+		const VectorRegister Age = VectorAdd(VectorLoad(&States.Ages[Idx]), VDeltaTime);
+
+		VelocityZ = VectorAdd(VelocityZ, VGravity);
+
+		// 吸引力随存在时间在0.5秒内增至最大
+		const VectorRegister ToTargetX = VectorSubtract(VectorLoad(&States.TargetX[Idx]), PositionX);
+		const VectorRegister ToTargetY = VectorSubtract(VectorLoad(&States.TargetY[Idx]), PositionY);
+		const VectorRegister ToTargetZ = VectorSubtract(VectorLoad(&States.TargetZ[Idx]), PositionZ);
+		const VectorRegister DistanceSquared = VectorMultiplyAdd(ToTargetX, ToTargetX, VectorMultiplyAdd(ToTargetY, ToTargetY, VectorMultiply(ToTargetZ, ToTargetZ)));
+		const VectorRegister InvDistance = VectorReciprocalSqrt(VectorMax(DistanceSquared, VMinDistanceSquared));
+		const VectorRegister AttractionScale = VectorMin(VectorMax(VectorMultiply(Age, VTwo), VZero), VOne);
+		// 距离为0时方向无意义，ToTarget本身为0所以结果为0
+		const VectorRegister Attraction = VectorMultiply(VectorMultiply(VectorLoad(&States.Attractions[Idx]), AttractionScale), VectorMultiply(InvDistance, VDeltaTime));
+		VelocityX = VectorMultiplyAdd(ToTargetX, Attraction, VelocityX);
+		VelocityZ = VectorMultiplyAdd(ToTargetZ, Attraction, VelocityZ);
+
+		PositionX = VectorMultiplyAdd(VelocityX, VDeltaTime, PositionX);
+		PositionZ = VectorMultiplyAdd(VelocityZ, VDeltaTime, PositionZ);
+
+		VectorStore(PositionX, &States.PositionX[Idx]);
+		VectorStore(PositionZ, &States.PositionZ[Idx]);
+		VectorStore(VelocityX, &States.VelocityX[Idx]);
+		VectorStore(VelocityZ, &States.VelocityZ[Idx]);
+		VectorStore(Age, &States.Ages[Idx]);
+	}
+}
+
+void ASmileDropletSimulation::ResolveContacts()
+{
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		if (States.HasContacts[Idx] == false)
+		{
+			continue;
+		}
+
+		const float Radius = DropletRadius * States.Scales[Idx];
+		const FVector& Normal = States.ContactNormals[Idx];
+		FVector Position = States.GetPosition(Idx);
+		const float Penetration = Radius - FVector::DotProduct(Position - States.ContactPoints[Idx], Normal);
+		if (Penetration > 0.f)
+		{
+			Position += Normal * Penetration;
+			States.SetPosition(Idx, Position);
+
+			// 去掉撞向表面的速度，沿表面滑动并按摩擦衰减
+			FVector Velocity = States.GetVelocity(Idx);
+			const float NormalSpeed = FVector::DotProduct(Velocity, Normal);
+			if (NormalSpeed < 0.f)
+			{
+				Velocity = (Velocity - Normal * NormalSpeed) * FMath::Clamp(1.f - ContactFriction, 0.f, 1.f);
+				States.SetVelocity(Idx, Velocity);
+			}
+		}
+	}
+}
+
+void ASmileDropletSimulation::MergeDroplets()
+{
+	using namespace DropletUtils;
+
+	float MaxRadius = 0.f;
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		MaxRadius = FMath::Max(MaxRadius, States.Scales[Idx]);
+	}
+	MaxRadius *= DropletRadius;
+	if (MaxRadius <= 0.f)
+	{
+		return;
+	}
+
+	const float InvCellSize = 1.f / (MaxRadius * 2.f);
+	CellHeads.Reset();
+	NextInCells.SetNumUninitialized(States.Num, false);
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		int32& Head = CellHeads.FindOrAdd(ToCell(States.GetPosition(Idx), InvCellSize), INDEX_NONE);
+		NextInCells[Idx] = Head;
+		Head = Idx;
+	}
+
+	PendingRemoves.Reset();
+	PendingRemoves.SetNumZeroed(States.Num, false);
+
+	const auto ForEachNearby = [&](const FVector& Position, float SearchRadius, TFunctionRef<void(int32)> Func)
+	{
+		const FIntVector MinCell = ToCell(Position - FVector(SearchRadius), InvCellSize);
+		const FIntVector MaxCell = ToCell(Position + FVector(SearchRadius), InvCellSize);
+		for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+				{
+					if (const int32* Head = CellHeads.Find(FIntVector(X, Y, Z)))
+					{
+						for (int32 Other = *Head; Other != INDEX_NONE; Other = NextInCells[Other])
+						{
+							Func(Other);
+						}
+					}
+				}
+			}
+		}
+	};
+
+	// 碎片之间合并，按体积加权合并位置与速度
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		if (PendingRemoves[Idx] || States.Ages[Idx] < MergeDelay)
+		{
+			continue;
+		}
+		ForEachNearby(States.GetPosition(Idx), MaxRadius * 2.f, [&](int32 Other)
+		{
+			if (Other <= Idx || PendingRemoves[Other] || States.Ages[Other] < MergeDelay)
+			{
+				return;
+			}
+			const float Scale = States.Scales[Idx];
+			const float OtherScale = States.Scales[Other];
+			const float MergeDistance = (Scale + OtherScale) * DropletRadius;
+			if (FVector::DistSquared(States.GetPosition(Idx), States.GetPosition(Other)) < FMath::Square(MergeDistance))
+			{
+				const float MergedScale = Scale + OtherScale;
+				States.SetPosition(Idx, (States.GetPosition(Idx) * Scale + States.GetPosition(Other) * OtherScale) / MergedScale);
+				States.SetVelocity(Idx, (States.GetVelocity(Idx) * Scale + States.GetVelocity(Other) * OtherScale) / MergedScale);
+				States.Scales[Idx] = MergedScale;
+				States.Attractions[Idx] = BodyAttractionCurve ? BodyAttractionCurve->GetFloatValue(MergedScale) : 0.f;
+				PendingRemoves[Other] = true;
+			}
+		});
+	}
+
+	// 碎片与本体合并
+	for (const TWeakObjectPtr<ASmile>& SlimePtr : Slimes)
+	{
+		ASmile* Slime = SlimePtr.Get();
+		if (Slime == nullptr)
+		{
+			continue;
+		}
+		const FVector SlimeLocation = Slime->GetActorLocation();
+		const float SlimeRadius = Slime->GetCapsuleComponent()->GetScaledCapsuleRadius();
+		ForEachNearby(SlimeLocation, SlimeRadius + MaxRadius, [&](int32 Other)
+		{
+			if (PendingRemoves[Other] || States.Ages[Other] < MergeDelay)
+			{
+				return;
+			}
+			const float MergeDistance = SlimeRadius + States.Scales[Other] * DropletRadius;
+			if (FVector::DistSquared(SlimeLocation, States.GetPosition(Other)) < FMath::Square(MergeDistance))
+			{
+				Slime->AbsorbScale(States.Scales[Other]);
+				PendingRemoves[Other] = true;
+			}
+		});
+	}
+
+	for (int32 Idx = States.Num - 1; Idx >= 0; --Idx)
+	{
+		if (PendingRemoves[Idx])
+		{
+			States.RemoveAtSwap(Idx);
+			DropletMeshes->RemoveInstance(States.Num);
+		}
+	}
+}
+
+void ASmileDropletSimulation::SubmitTraces(float DeltaTime)
+{
+	// 异步批量检测下一帧的接触面，结果在下一帧Tick开始时读取
+	UWorld* World = GetWorld();
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SmileDroplet), false, this);
+	for (const TWeakObjectPtr<ASmile>& Slime : Slimes)
+	{
+		if (Slime.IsValid())
+		{
+			QueryParams.AddIgnoredActor(Slime.Get());
+		}
+	}
+
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		const float Radius = DropletRadius * States.Scales[Idx];
+		const FVector Start = States.GetPosition(Idx);
+		const FVector End = Start + States.GetVelocity(Idx) * (DeltaTime * 2.f) + FVector(0.f, 0.f, -Radius * 1.5f);
+		States.TraceHandles[Idx] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, TraceChannel, QueryParams);
+	}
+}
+
+void ASmileDropletSimulation::UpdateInstances()
+{
+	InstanceTransforms.SetNum(States.Num, false);
+	for (int32 Idx = 0; Idx < States.Num; ++Idx)
+	{
+		InstanceTransforms[Idx] = FTransform(FQuat::Identity, States.GetPosition(Idx), FVector(States.Scales[Idx]));
+	}
+	DropletMeshes->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+}
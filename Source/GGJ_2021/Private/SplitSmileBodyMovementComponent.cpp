@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SplitSmileBodyMovementComponent.h"
+#include <Components/PrimitiveComponent.h>
+
+#include "GGJ_Character.h"
+
+USplitSmileBodyMovementComponent::USplitSmileBodyMovementComponent()
+	: bIsSleeping(false)
+{
+	bUpdateOnlyIfRendered = false;
+}
+
+void USplitSmileBodyMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	ASplitSmileBody* Body = CastChecked<ASplitSmileBody>(GetOwner());
+	if (ShouldSkipUpdate(DeltaTime) || UpdatedComponent == nullptr || DeltaTime <= 0.f)
+	{
+		return;
+	}
+
+	// 跟随站立的物体移动，代替每帧挂接与解除挂接
+	FVector BaseDelta = FVector::ZeroVector;
+	if (const UPrimitiveComponent* Base = BaseComponent.Get())
+	{
+		const FVector BaseLocation = Base->GetComponentLocation();
+		const FQuat BaseRotation = Base->GetComponentQuat();
+		if (BaseLocation.Equals(LastBaseLocation) == false || BaseRotation.Equals(LastBaseRotation) == false)
+		{
+			const FVector LocalOffset = LastBaseRotation.UnrotateVector(UpdatedComponent->GetComponentLocation() - LastBaseLocation);
+			BaseDelta = BaseLocation + BaseRotation.RotateVector(LocalOffset) - UpdatedComponent->GetComponentLocation();
+			LastBaseLocation = BaseLocation;
+			LastBaseRotation = BaseRotation;
+		}
+	}
+
+	Velocity.Y = 0.f;
+
+	const FVector PreLocation = UpdatedComponent->GetComponentLocation();
+
+	const float GravityScale = (Body->BodyScale - 0.2f);
+	Velocity += FVector(0.f, 0.f, -4000.f * GravityScale) * DeltaTime;
+
+	const FVector Delta = Velocity * DeltaTime;
+	FHitResult HitResult;
+	SafeMoveUpdatedComponent(BaseDelta + Delta, UpdatedComponent->GetComponentQuat(), true, HitResult);
+	if (HitResult.IsValidBlockingHit())
+	{
+		SlideAlongSurface(Delta * (1.f - GravityScale), 1.f - HitResult.Time, HitResult.Normal, HitResult, true);
+		SetBaseComponent(HitResult.Component.Get());
+	}
+	else
+	{
+		SetBaseComponent(nullptr);
+	}
+
+	Velocity = (UpdatedComponent->GetComponentLocation() - PreLocation - BaseDelta) / DeltaTime;
+	UpdateComponentVelocity();
+
+	// 只在不会移动的物体上休眠，可移动的物体需要持续跟随
+	const UPrimitiveComponent* Base = BaseComponent.Get();
+	if (Base && Base->Mobility != EComponentMobility::Movable && Velocity.SizeSquared() < FMath::Square(SleepVelocityThreshold))
+	{
+		RestTime += DeltaTime;
+		if (RestTime >= SleepDelay)
+		{
+			Velocity = FVector::ZeroVector;
+			UpdateComponentVelocity();
+			bIsSleeping = true;
+			SetComponentTickEnabled(false);
+			Body->SetActorTickEnabled(false);
+		}
+	}
+	else
+	{
+		RestTime = 0.f;
+	}
+}
+
+void USplitSmileBodyMovementComponent::WakeUp()
+{
+	if (bIsSleeping)
+	{
+		bIsSleeping = false;
+		RestTime = 0.f;
+		SetComponentTickEnabled(true);
+		GetOwner()->SetActorTickEnabled(true);
+	}
+}
+
+void USplitSmileBodyMovementComponent::ResetMovementState()
+{
+	BaseComponent = nullptr;
+	LastBaseLocation = FVector::ZeroVector;
+	LastBaseRotation = FQuat::Identity;
+	Velocity = FVector::ZeroVector;
+	RestTime = 0.f;
+	bIsSleeping = false;
+	SetComponentTickEnabled(true);
+}
+
+void USplitSmileBodyMovementComponent::SetBaseComponent(UPrimitiveComponent* NewBase)
+{
+	if (BaseComponent.Get() != NewBase)
+	{
+		BaseComponent = NewBase;
+		if (NewBase)
+		{
+			LastBaseLocation = NewBase->GetComponentLocation();
+			LastBaseRotation = NewBase->GetComponentQuat();
+		}
+	}
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Engine/NetSerialization.h"
 #include "GGJ_Character.generated.h"
 
 UCLASS()
@@ -20,19 +21,124 @@ class GGJ_2021_API ASplitSmileBody : public AActor
 	GENERATED_BODY()
 public:
 	ASplitSmileBody();
-	
-	void Tick(float DeltaTime) override;
 
-	UPROPERTY(BlueprintReadOnly)
-	FVector Velocity;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	class USplitSmileBodyMovementComponent* MovementComponent;
 
-	UPROPERTY(BlueprintReadOnly)
-	uint8 bCanCombine : 1;
+	// 速度只保存在移动组件中
+	FVector GetVelocity() const override;
+	// 修改速度并在需要时唤醒休眠的分裂体
+	void SetVelocity(const FVector& NewVelocity);
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	float BodyScale = 0.f;
 
+	void PostInitializeComponents() override;
 	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// 分裂体由本体的对象池管理，分裂时激活，合体时反激活放回池中
+	virtual void ActivateBody(const FVector& Location, const FRotator& Rotation, float InBodyScale, const FVector& InVelocity);
+	virtual void DeactivateBody();
+	bool IsBodyActived() const { return bIsBodyActived; }
+
+	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "When Body Actived"))
+	void ReceiveActivateBody();
+
+	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "When Body Deactived"))
+	void ReceiveDeactivateBody();
+
+	// 服务器分配的同步编号，未确认的预测分裂体为INDEX_NONE
+	int32 NetBodyId = INDEX_NONE;
+	// 主控端预测分裂时的编号，用于匹配服务器下发的分裂体
+	uint8 NetPredictionKey = 0;
+private:
+	uint8 bIsBodyActived : 1;
+	FName DefaultCollisionProfileName;
+};
+
+// 分裂体的状态按数组连续存储，每帧批量计算吸引力与合体检测
+struct FSmileSplitBodyStates
+{
+	TArray<FVector> Locations;
+	TArray<FVector> Velocities;
+	TArray<float> Scales;
+	TArray<float> Radii;
+	TArray<float> SplitTimes;
+	// 分裂体离开过本体后才允许合体
+	TArray<bool> CanCombines;
+
+	int32 Num() const { return Locations.Num(); }
+	void Add(const FVector& Location, const FVector& Velocity, float Scale, float Radius, float SplitTime);
+	void RemoveAtSwap(int32 Index);
+	void Empty();
+};
+
+class ASmile;
+struct FSmileSplitBodyNetStates;
+
+// 分裂体的同步状态，位置为相对本体的偏移，位置与速度量化后序列化
+USTRUCT()
+struct FSmileSplitBodyNetState : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY()
+	uint8 BodyId = 0;
+
+	UPROPERTY()
+	uint8 PredictionKey = 0;
+
+	UPROPERTY()
+	FVector Offset = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector Velocity = FVector::ZeroVector;
+
+	UPROPERTY()
+	float Scale = 0.f;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	void PreReplicatedRemove(const FSmileSplitBodyNetStates& InArraySerializer);
+	void PostReplicatedAdd(const FSmileSplitBodyNetStates& InArraySerializer);
+	void PostReplicatedChange(const FSmileSplitBodyNetStates& InArraySerializer);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSmileSplitBodyNetState> : public TStructOpsTypeTraitsBase2<FSmileSplitBodyNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+// 只下发变化的分裂体状态
+USTRUCT()
+struct FSmileSplitBodyNetStates : public FFastArraySerializer
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY()
+	TArray<FSmileSplitBodyNetState> Items;
+
+	ASmile* Owner = nullptr;
+
+	FSmileSplitBodyNetState* FindByBodyId(int32 BodyId);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FSmileSplitBodyNetState, FSmileSplitBodyNetStates>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FSmileSplitBodyNetStates> : public TStructOpsTypeTraitsBase2<FSmileSplitBodyNetStates>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
 };
 
 UCLASS()
@@ -52,23 +158,116 @@ public:
 	UPROPERTY(EditAnywhere)
 	uint8 bDrawDebug : 1;
 	
+	UPROPERTY(EditAnywhere)
+	int32 MaxSplitBodyNum = 4;
+
+	// 本体与分裂体的距离小于两者半径之和加上该值时合体
+	UPROPERTY(EditAnywhere)
+	float CombineDistanceTolerance = 0.f;
+
+	// 最近分裂出的分裂体
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	ASplitSmileBody* SplitBody;
 
-	UPROPERTY(BlueprintReadWrite)
+	// 与BodyStates下标一一对应
+	UPROPERTY(BlueprintReadOnly)
+	TArray<ASplitSmileBody*> SplitBodies;
+	FSmileSplitBodyStates BodyStates;
+
+	UPROPERTY(BlueprintReadWrite, ReplicatedUsing = OnRep_IsInvokeCombine)
 	uint8 bIsInvokeCombine : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_BodyScale)
 	float BodyScale = 1.f;
 
+	// 分裂体偏移或速度的变化超过容差时才同步
+	UPROPERTY(EditAnywhere)
+	float NetLocationTolerance = 2.f;
+
+	UPROPERTY(EditAnywhere)
+	float NetVelocityTolerance = 10.f;
+
+	// 客户端分裂体与服务器的误差超过该值时直接拉回，否则通过速度修正
+	UPROPERTY(EditAnywhere)
+	float NetSnapDistance = 150.f;
+
+	UPROPERTY(EditAnywhere)
+	float NetCorrectionStrength = 5.f;
+
+	// 预测的分裂超过该时间未被服务器确认则回退
+	UPROPERTY(EditAnywhere)
+	float SplitPredictionTimeout = 1.f;
+
+	// 开始时预先创建分裂体，分裂与合体时不再生成与销毁Actor
+	UPROPERTY(EditAnywhere)
+	uint8 bPrewarmSplitBodyPool : 1;
+
+	UPROPERTY(Transient)
+	TArray<ASplitSmileBody*> SplitBodyPool;
+
+	// 碎裂时使用的碎片模拟，同一世界中共享一个
+	UPROPERTY(EditAnywhere)
+	TSubclassOf<class ASmileDropletSimulation> DropletSimulationClass;
+
+	ASmile();
+	void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const override;
+	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	void Tick(float DeltaTime) override;
-	void TryCombine();
-	void NotifyActorBeginOverlap(AActor* OtherActor) override;
-	void NotifyActorEndOverlap(AActor* OtherActor) override;
+	void TryCombine(ASplitSmileBody* Body);
+	// 移除激活的分裂体，bMergeScale为假时体积由服务器同步
+	void RemoveSplitBody(ASplitSmileBody* Body, bool bMergeScale = true);
+
+	ASplitSmileBody* AcquireSplitBody();
+	void ReleaseSplitBody(ASplitSmileBody* Body);
 
 	UFUNCTION(BlueprintCallable)
 	void Split(const FVector& Velocity, float LostScale);
 
 	UFUNCTION(BlueprintCallable)
 	void Combine();
+
+	// 碎裂成大量碎片，碎片由ASmileDropletSimulation批量模拟
+	UFUNCTION(BlueprintCallable)
+	void Shatter(const FVector& Velocity, float LostScale, int32 DropletNum = 16, float SpreadAngle = 60.f);
+	// 碎片回到本体时合并其体积，只在服务器修改，客户端的碎片合并只是表现
+	void AbsorbScale(float Scale);
+
+	void WhenSplitBodyNetStateAdded(const FSmileSplitBodyNetState& NetState);
+	void WhenSplitBodyNetStateChanged(const FSmileSplitBodyNetState& NetState);
+	void WhenSplitBodyNetStateRemoved(const FSmileSplitBodyNetState& NetState);
+private:
+	ASplitSmileBody* SplitImpl(const FVector& Velocity, float LostScale);
+	// 按随机种子生成碎片，各端生成相同的碎片，返回实际生成的数量
+	int32 ShatterImpl(const FVector& Velocity, float LostScale, int32 DropletNum, float SpreadAngle, int32 RandomSeed);
+	void AddSplitBody(ASplitSmileBody* Body, const FVector& Velocity);
+	void StartCombine();
+	ASplitSmileBody* FindSplitBodyByNetId(int32 BodyId) const;
+
+	UPROPERTY(Replicated)
+	FSmileSplitBodyNetStates SplitBodyNetStates;
+	void AddSplitBodyNetState(ASplitSmileBody* Body, uint8 PredictionKey);
+	void UpdateSplitBodyNetStates();
+	void ApplySplitBodyNetState(ASplitSmileBody* Body, const FSmileSplitBodyNetState& NetState);
+	uint8 NextNetBodyId = 0;
+	uint8 NextPredictionKey = 0;
+
+	// 同一帧内的合体事件合并为一次广播
+	TArray<uint8> PendingCombineBodyIds;
+
+	UFUNCTION()
+	void OnRep_BodyScale();
+	UFUNCTION()
+	void OnRep_IsInvokeCombine();
+
+	UFUNCTION(Server, Reliable)
+	void SplitToServer(const FVector_NetQuantize10& Velocity, float LostScale, uint8 PredictionKey);
+	UFUNCTION(Server, Reliable)
+	void CombineToServer();
+	UFUNCTION(Server, Reliable)
+	void ShatterToServer(const FVector_NetQuantize10& Velocity, float LostScale, int32 DropletNum, float SpreadAngle, int32 RandomSeed);
+	UFUNCTION(NetMulticast, Unreliable)
+	void ShatterNetMulticast(const FVector_NetQuantize10& Velocity, float LostScale, int32 DropletNum, float SpreadAngle, int32 RandomSeed);
+	UFUNCTION(NetMulticast, Unreliable)
+	void CombineSplitBodiesNetMulticast(const TArray<uint8>& BodyIds);
 };
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "WorldCollision.h"
+#include "SmileDropletSimulation.generated.h"
+
+class ASmile;
+class UCurveFloat;
+class UInstancedStaticMeshComponent;
+
+// 碎片状态按分量连续存储，数组长度补齐到4的倍数以便SIMD批量积分
+struct FSmileDropletStates
+{
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+	TArray<float> Scales;
+	TArray<float> Attractions;
+	TArray<float> Ages;
+	// 吸引的目标位置，每帧从所属本体收集
+	TArray<float> TargetX;
+	TArray<float> TargetY;
+	TArray<float> TargetZ;
+
+	TArray<int32> OwnerIndices;
+	TArray<FTraceHandle> TraceHandles;
+	TArray<FVector> ContactPoints;
+	TArray<FVector> ContactNormals;
+	TArray<bool> HasContacts;
+
+	int32 Num = 0;
+
+	int32 Add();
+	void RemoveAtSwap(int32 Index);
+	FVector GetPosition(int32 Index) const { return FVector(PositionX[Index], PositionY[Index], PositionZ[Index]); }
+	void SetPosition(int32 Index, const FVector& Position);
+	FVector GetVelocity(int32 Index) const { return FVector(VelocityX[Index], VelocityY[Index], VelocityZ[Index]); }
+	void SetVelocity(int32 Index, const FVector& Velocity);
+};
+
+/**
+ * 史莱姆碎裂后的大量碎片模拟
+ * 所有碎片在一个Actor中批量积分，空间哈希检测碎片间与碎片和本体的合并，异步批量检测碰撞，使用实例化网格渲染
+ */
+UCLASS()
+class GGJ_2021_API ASmileDropletSimulation : public AActor
+{
+	GENERATED_BODY()
+public:
+	ASmileDropletSimulation();
+
+	void Tick(float DeltaTime) override;
+
+	UPROPERTY(VisibleAnywhere)
+	UInstancedStaticMeshComponent* DropletMeshes;
+
+	// 缩放为1时碎片网格的半径
+	UPROPERTY(EditAnywhere)
+	float DropletRadius = 50.f;
+
+	// 碎片的缩放远小于本体，不使用本体随缩放变化的重力
+	UPROPERTY(EditAnywhere)
+	float DropletGravity = 2000.f;
+
+	// 接触表面时每次碰撞损失的切向速度比例
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0", ClampMax = "1"))
+	float ContactFriction = 0.2f;
+
+	UPROPERTY(EditAnywhere)
+	UCurveFloat* BodyAttractionCurve;
+
+	// 碎片生成后经过该时间才允许合并
+	UPROPERTY(EditAnywhere)
+	float MergeDelay = 0.1f;
+
+	UPROPERTY(EditAnywhere)
+	int32 MaxDropletNum = 512;
+
+	UPROPERTY(EditAnywhere)
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_WorldStatic;
+
+	// 碎片数量达到上限时返回false
+	UFUNCTION(BlueprintCallable)
+	bool EmitDroplet(ASmile* SourceSmile, const FVector& Location, const FVector& Velocity, float Scale);
+
+	int32 GetDropletNum() const { return States.Num; }
+private:
+	void ResolveTraceResults();
+	void GatherTargets();
+	void Integrate(float DeltaTime);
+	void ResolveContacts();
+	void MergeDroplets();
+	void SubmitTraces(float DeltaTime);
+	void UpdateInstances();
+
+	FSmileDropletStates States;
+	TArray<TWeakObjectPtr<ASmile>> Slimes;
+	TArray<bool> PendingRemoves;
+
+	// 空间哈希：格子到首个碎片，NextInCells串联同一格子的碎片
+	TMap<FIntVector, int32> CellHeads;
+	TArray<int32> NextInCells;
+
+	TArray<FTransform> InstanceTransforms;
+};
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/MovementComponent.h"
+#include "SplitSmileBodyMovementComponent.generated.h"
+
+/**
+ * 分裂体的移动，单次扫掠并沿阻挡面滑动
+ * 跟随站立的物体移动而不挂接，在静态物体上静止后休眠，休眠时组件与Actor都不再Tick
+ */
+UCLASS()
+class GGJ_2021_API USplitSmileBodyMovementComponent : public UMovementComponent
+{
+	GENERATED_BODY()
+public:
+	USplitSmileBodyMovementComponent();
+
+	void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	UPROPERTY(EditAnywhere)
+	float SleepVelocityThreshold = 5.f;
+
+	UPROPERTY(EditAnywhere)
+	float SleepDelay = 0.5f;
+
+	void WakeUp();
+	// 分裂体从对象池重新激活时清除上一次激活残留的站立物体与休眠状态
+	void ResetMovementState();
+	bool IsSleeping() const { return bIsSleeping; }
+	UPrimitiveComponent* GetBaseComponent() const { return BaseComponent.Get(); }
+private:
+	void SetBaseComponent(UPrimitiveComponent* NewBase);
+
+	uint8 bIsSleeping : 1;
+	float RestTime = 0.f;
+
+	TWeakObjectPtr<UPrimitiveComponent> BaseComponent;
+	FVector LastBaseLocation;
+	FQuat LastBaseRotation;
+};